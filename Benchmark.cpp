@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <thread>
+#include "sources/MagicalContainer.hpp"
+
+using namespace ariel;
+
+// Reader throughput of a shared container. Every reader does the same fixed amount of work whatever
+// the number of readers, so the total throughput grows with the readers as long as they don't block each other.
+// Readers either read in batches with nextBatch, or one element at a time with ++ and *, which locks on every call.
+// Usage: ./benchmark [max readers] [elements] [passes per reader]
+enum class Reading
+{
+    Batches,
+    Elements
+};
+
+static double readElementsPerSecond(MagicalContainer &container, unsigned readers, int passes, Reading reading)
+{
+    std::atomic<long long> checksum(0);
+    auto read = [&]()
+    {
+        MagicalContainer::AscendingIterator iterator(container);
+        std::vector<int> buffer(1024);
+        long long sum = 0;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            if (reading == Reading::Batches)
+            {
+                MagicalContainer::AscendingIterator walker = iterator.begin();
+                while (size_t count = walker.nextBatch(buffer))
+                {
+                    sum = std::accumulate(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(count), sum);
+                }
+            }
+            else
+            {
+                MagicalContainer::AscendingIterator end = iterator.end();
+                for (MagicalContainer::AscendingIterator walker = iterator.begin(); walker != end; ++walker)
+                {
+                    sum += *walker;
+                }
+            }
+        }
+        checksum += sum;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned reader = 0; reader < readers; ++reader)
+    {
+        threads.emplace_back(read);
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // The checksum keeps the reads from being optimized away
+    if (checksum.load() == 0)
+    {
+        std::cout << "empty checksum\n";
+    }
+    return static_cast<double>(readers) * passes * container.size() / elapsed.count();
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned maxReaders = (argc > 1) ? static_cast<unsigned>(std::atoi(argv[1])) : std::max(std::thread::hardware_concurrency(), 1U);
+    int elements = (argc > 2) ? std::atoi(argv[2]) : 4000000;
+    int passes = (argc > 3) ? std::atoi(argv[3]) : 20;
+
+    std::vector<int> values(static_cast<size_t>(elements));
+    std::iota(values.begin(), values.end(), 1);
+
+    MagicalContainer single;
+    single.addElements(values);
+    MagicalContainer shared(Threading::Shared);
+    shared.addElements(values);
+
+    for (Reading reading : {Reading::Batches, Reading::Elements})
+    {
+        const char *name = (reading == Reading::Batches) ? "batches" : "elements";
+        double unlocked = readElementsPerSecond(single, 1, passes, reading);
+        std::cout << name << ", single thread container, 1 reader: " << unlocked / 1e6 << " M elements/s\n";
+
+        double base = 0;
+        for (unsigned readers = 1; readers <= maxReaders; readers *= 2)
+        {
+            double throughput = readElementsPerSecond(shared, readers, passes, reading);
+            if (readers == 1)
+            {
+                base = throughput;
+            }
+            std::cout << name << ", shared container, " << readers << " readers: " << throughput / 1e6 << " M elements/s, speedup " << throughput / base << "\n";
+        }
+    }
+    return 0;
+}
@@ -22,7 +22,14 @@ int main() {
     }
     std::cout << std::endl;
 
-    // Use DescendingIterator to display elements in descending order
+    // Walk the AscendingIterator backwards to display elements in descending order
+    std::cout << "Elements in descending order:\n";
+    for (auto it = ascIter.rbegin(); it != ascIter.rend(); ++it) {
+        std::cout << *it << ' ';   // 25 17 9 3 2
+    }
+    std::cout << std::endl;
+
+    // Use SideCrossIterator to display elements in cross order
     std::cout << "Elements in cross order:\n";
     MagicalContainer::SideCrossIterator crossIter(container);
     for (auto it = crossIter.begin(); it != crossIter.end(); ++it) {
@@ -1,6 +1,16 @@
 #include "doctest.h"
-#include "sources/MagicalContainer.hpp"
+#include "sources/BPlusTree.hpp"
+#include "sources/FilterPredicates.hpp"
+#include "sources/MagicalContainerImpl.hpp"
+#include "sources/ParallelForEach.hpp"
+#include "sources/ReadMostlyLock.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <ranges>
 #include <stdexcept>
+#include <thread>
 
 using namespace ariel;
 using namespace std;
@@ -597,3 +607,1353 @@ TEST_CASE("operator= throws when iterators are pointing at different containers"
 }
 
 
+
+TEST_CASE("AscendingIterator reads the container without copying it") {
+    MagicalContainer container;
+    container.addElement(10);
+    container.addElement(30);
+
+    MagicalContainer::AscendingIterator it(container);
+    CHECK(*it == 10);
+
+    SUBCASE("Elements added after creation are visited") {
+        container.addElement(20);
+        ++it;
+        CHECK(*it == 20);
+        ++it;
+        CHECK(*it == 30);
+        ++it;
+        CHECK(it == it.end());
+    }
+
+    SUBCASE("Dereferenced element is read from the container on every access") {
+        MagicalContainer::AscendingIterator other(container);
+        CHECK(*it == *other);
+        container.removeElement(10);
+        CHECK(*it == 30);
+        CHECK(*other == 30);
+    }
+}
+
+TEST_CASE("SideCrossIterator computes the cross order from the sorted container") {
+    MagicalContainer container;
+    for (int i = 1; i <= 6; ++i) {
+        container.addElement(i);
+    }
+
+    SUBCASE("Even and odd sizes") {
+        vector<int> crossOrder;
+        MagicalContainer::SideCrossIterator it(container);
+        for (auto iter = it.begin(); iter != it.end(); ++iter) {
+            crossOrder.push_back(*iter);
+        }
+        CHECK(crossOrder == vector<int>{1, 6, 2, 5, 3, 4});
+
+        container.addElement(7);
+        crossOrder.clear();
+        for (auto iter = it.begin(); iter != it.end(); ++iter) {
+            crossOrder.push_back(*iter);
+        }
+        CHECK(crossOrder == vector<int>{1, 7, 2, 6, 3, 5, 4});
+    }
+
+    SUBCASE("Iterator keeps its element when the cross order changes") {
+        MagicalContainer::SideCrossIterator it(container);
+        ++it;
+        CHECK(*it == 6);
+        container.addElement(10);
+        CHECK(*it == 6);
+        ++it;
+        CHECK(*it == 3);
+    }
+}
+
+TEST_CASE("end() marks the position past the last element") {
+    MagicalContainer container;
+    container.addElement(2);
+    container.addElement(4);
+    container.addElement(7);
+
+    SUBCASE("AscendingIterator") {
+        MagicalContainer::AscendingIterator it(container);
+        CHECK(it < it.end());
+        CHECK(it.end() > it);
+        ++(++(++it));
+        CHECK(it == it.end());
+        CHECK_FALSE(it < it.end());
+    }
+
+    SUBCASE("SideCrossIterator") {
+        MagicalContainer::SideCrossIterator it(container);
+        CHECK(it < it.end());
+        ++(++(++it));
+        CHECK(it == it.end());
+    }
+
+    SUBCASE("PrimeIterator") {
+        MagicalContainer::PrimeIterator it(container);
+        CHECK(it < it.end());
+        CHECK(it != it.end());
+        ++(++it);
+        CHECK(it == it.end());
+        CHECK(it.end() == it);
+        CHECK_FALSE(it < it.end());
+    }
+}
+
+TEST_CASE("PrimeIterator follows the container's prime index") {
+    MagicalContainer container;
+    container.addElement(4);
+    container.addElement(7);
+    container.addElement(9);
+    container.addElement(13);
+
+    MagicalContainer::PrimeIterator it(container);
+    CHECK(*it == 7);
+
+    SUBCASE("Primes added after creation are visited") {
+        container.addElement(11);
+        container.addElement(10);
+        ++it;
+        CHECK(*it == 11);
+        ++it;
+        CHECK(*it == 13);
+        ++it;
+        CHECK(it == it.end());
+    }
+
+    SUBCASE("Removed primes are skipped") {
+        container.removeElement(7);
+        CHECK(*it == 13);
+        container.removeElement(4);
+        CHECK(*it == 13);
+        ++it;
+        CHECK(it == it.end());
+    }
+}
+
+TEST_CASE("Comparing iterators of different kinds throws") {
+    MagicalContainer container;
+    container.addElement(2);
+    container.addElement(3);
+
+    MagicalContainer::AscendingIterator asc(container);
+    MagicalContainer::SideCrossIterator cross(container);
+    MagicalContainer::PrimeIterator prime(container);
+
+    CHECK_THROWS_AS((void)asc.operator==(cross), runtime_error);
+    CHECK_THROWS_AS((void)cross.operator<(prime), runtime_error);
+    CHECK_THROWS_AS((void)prime.operator>(asc), runtime_error);
+    CHECK_THROWS_AS((void)asc.operator!=(prime), runtime_error);
+}
+
+TEST_CASE("Iterators compare their positions and not their elements") {
+    MagicalContainer container;
+    container.addElement(1);
+    container.addElement(2);
+    container.addElement(4);
+    container.addElement(5);
+    container.addElement(14);
+
+    SUBCASE("SideCrossIterator") {
+        MagicalContainer::SideCrossIterator first(container);
+        MagicalContainer::SideCrossIterator second(container);
+        ++second;
+        CHECK(*second == 14);
+        ++first;
+        ++first;
+        CHECK(*first == 2);
+
+        // 2 comes after 14 in cross order even though it's smaller
+        CHECK(first > second);
+        CHECK(first >= second);
+        CHECK(second < first);
+        CHECK(second <= first);
+        CHECK_FALSE(first <= second);
+    }
+
+    SUBCASE("AscendingIterator") {
+        MagicalContainer::AscendingIterator first(container);
+        MagicalContainer::AscendingIterator second(container);
+        CHECK(first <= second);
+        CHECK(first >= second);
+        ++second;
+        CHECK(first <= second);
+        CHECK_FALSE(first >= second);
+    }
+}
+
+TEST_CASE("Live iterators are notified about changes in the container") {
+    MagicalContainer container;
+    container.addElement(10);
+    container.addElement(20);
+    container.addElement(30);
+
+    SUBCASE("AscendingIterator keeps pointing on the same element") {
+        MagicalContainer::AscendingIterator it(container);
+        ++it;
+        CHECK(*it == 20);
+        container.addElement(5);
+        CHECK(*it == 20);
+        container.removeElement(10);
+        CHECK(*it == 20);
+        container.removeElement(20);
+        CHECK(*it == 30);
+    }
+
+    SUBCASE("Exhausted iterator visits elements added at the end") {
+        MagicalContainer::AscendingIterator it(container);
+        MagicalContainer::AscendingIterator end = it.end();
+        while (it != it.end()) {
+            ++it;
+        }
+        container.addElement(1);
+        CHECK(it == it.end());
+        container.addElement(40);
+        CHECK(*it == 40);
+        CHECK(*end == 40);
+    }
+
+    SUBCASE("PrimeIterator moves only when a prime changes") {
+        container.addElement(7);
+        container.addElement(13);
+        MagicalContainer::PrimeIterator it(container);
+        ++it;
+        CHECK(*it == 13);
+        container.addElement(2);
+        container.addElement(12);
+        CHECK(*it == 13);
+        container.removeElement(7);
+        CHECK(*it == 13);
+    }
+
+    SUBCASE("Iterators outliving their container are detached") {
+        MagicalContainer::AscendingIterator *it = nullptr;
+        {
+            MagicalContainer temporary;
+            temporary.addElement(1);
+            it = new MagicalContainer::AscendingIterator(temporary);
+            CHECK(**it == 1);
+        }
+        CHECK_THROWS_AS(**it, runtime_error);
+        delete it;
+    }
+}
+
+TEST_CASE("Iterators find their element again after several changes") {
+    MagicalContainer container;
+    for (int i = 1; i <= 9; ++i) {
+        container.addElement(i * 10);
+    }
+
+    MagicalContainer::AscendingIterator asc(container);
+    MagicalContainer::SideCrossIterator cross(container);
+    MagicalContainer::PrimeIterator prime(container);
+    ++(++(++asc));
+    ++(++cross);
+    CHECK(*asc == 40);
+    CHECK(*cross == 20);
+    CHECK(prime == prime.end());
+
+    // Several writes between two accesses of the iterators
+    container.addElement(5);
+    container.addElement(35);
+    container.removeElement(10);
+    container.addElement(7);
+    container.addElement(95);
+
+    CHECK(*asc == 40);
+    CHECK(*cross == 20);
+    CHECK(*prime == 5);
+
+    container.removeElement(40);
+    CHECK(*asc == 50);
+    ++asc;
+    CHECK(*asc == 60);
+}
+
+TEST_CASE("Stepping past an element removed after it was read") {
+    MagicalContainer container;
+    container.addElements(vector<int>{2, 3, 4, 5, 7, 11});
+
+    SUBCASE("++ lands on the successor instead of skipping it") {
+        MagicalContainer::AscendingIterator asc(container);
+        CHECK(*asc == 2);
+        container.removeElement(2);
+        ++asc;
+        CHECK(*asc == 3);
+        ++asc;
+        CHECK(*asc == 4);
+    }
+
+    SUBCASE("A run of removed elements") {
+        MagicalContainer::PrimeIterator prime(container);
+        ++prime;
+        CHECK(*prime == 3);
+        container.removeElement(3);
+        container.removeElement(5);
+        ++prime;
+        CHECK(*prime == 7);
+    }
+
+    SUBCASE("Offsets count the successor as the first step") {
+        MagicalContainer::AscendingIterator asc(container);
+        CHECK(*asc == 2);
+        container.removeElement(2);
+        asc += 2;
+        CHECK(*asc == 4);
+    }
+
+    SUBCASE("Removing the last element ends the traversal") {
+        MagicalContainer::FilterIterator<IsPerfectSquare> square(container);
+        CHECK(*square == 4);
+        container.removeElement(4);
+        ++square;
+        CHECK(square == square.end());
+    }
+}
+
+TEST_CASE("Adding a batch of elements") {
+    MagicalContainer container;
+    container.addElement(4);
+    container.addElement(10);
+
+    SUBCASE("Batch is merged into the sorted elements") {
+        vector<int> batch = {7, 1, 12, 5, 2};
+        container.addElements(batch);
+        CHECK(container.size() == 7);
+
+        vector<int> ascending;
+        MagicalContainer::AscendingIterator asc(container);
+        for (auto it = asc.begin(); it != asc.end(); ++it) {
+            ascending.push_back(*it);
+        }
+        CHECK(ascending == vector<int>{1, 2, 4, 5, 7, 10, 12});
+
+        vector<int> primes;
+        MagicalContainer::PrimeIterator prime(container);
+        for (auto it = prime.begin(); it != prime.end(); ++it) {
+            primes.push_back(*it);
+        }
+        CHECK(primes == vector<int>{2, 5, 7});
+    }
+
+    SUBCASE("Iterator pair overload") {
+        int batch[] = {3, 11};
+        container.addElements(begin(batch), end(batch));
+        CHECK(container.size() == 4);
+        MagicalContainer::PrimeIterator prime(container);
+        CHECK(*prime == 3);
+    }
+
+    SUBCASE("Duplicates reject the whole batch") {
+        CHECK_THROWS_AS(container.addElements(vector<int>{1, 10, 20}), invalid_argument);
+        CHECK_THROWS_AS(container.addElements(vector<int>{1, 3, 1}), invalid_argument);
+        CHECK(container.size() == 2);
+    }
+
+    SUBCASE("Live iterators keep their element") {
+        MagicalContainer::AscendingIterator asc(container);
+        ++asc;
+        CHECK(*asc == 10);
+        container.addElements(vector<int>{1, 2, 3, 20});
+        CHECK(*asc == 10);
+        ++asc;
+        CHECK(*asc == 20);
+    }
+}
+
+TEST_CASE("Removing a batch of elements") {
+    MagicalContainer container;
+    container.addElements(vector<int>{1, 2, 3, 4, 5, 6, 7, 8, 9});
+
+    SUBCASE("Batch is removed from the elements and the primes") {
+        container.removeElements(vector<int>{8, 2, 5, 1});
+        CHECK(container.size() == 5);
+
+        vector<int> ascending;
+        MagicalContainer::AscendingIterator asc(container);
+        for (auto it = asc.begin(); it != asc.end(); ++it) {
+            ascending.push_back(*it);
+        }
+        CHECK(ascending == vector<int>{3, 4, 6, 7, 9});
+
+        MagicalContainer::PrimeIterator prime(container);
+        CHECK(*prime == 3);
+        ++prime;
+        CHECK(*prime == 7);
+        ++prime;
+        CHECK(prime == prime.end());
+    }
+
+    SUBCASE("Iterator pair overload") {
+        int batch[] = {9, 4};
+        container.removeElements(begin(batch), end(batch));
+        CHECK(container.size() == 7);
+    }
+
+    SUBCASE("A missing element rejects the whole batch") {
+        CHECK_THROWS_AS(container.removeElements(vector<int>{1, 2, 42}), runtime_error);
+        CHECK_THROWS_AS(container.removeElements(vector<int>{3, 3}), runtime_error);
+        CHECK(container.size() == 9);
+    }
+}
+
+TEST_CASE("B+ tree storage") {
+    BPlusTree<int> tree;
+    bool inserted = true;
+    for (int i = 0; i < 1000; ++i) {
+        inserted = tree.insert((i * 7) % 1000) && inserted;
+    }
+    CHECK(inserted);
+    CHECK(tree.size() == 1000);
+    CHECK_FALSE(tree.insert(500));
+
+    SUBCASE("Ranks follow the sorted order") {
+        bool sorted = true;
+        for (size_t rank = 0; rank < tree.size(); ++rank) {
+            sorted = sorted && tree[rank] == static_cast<int>(rank);
+        }
+        CHECK(sorted);
+        CHECK(tree.lowerBound(250) == 250);
+        CHECK(tree.upperBound(250) == 251);
+        CHECK(tree.back() == 999);
+    }
+
+    SUBCASE("Erasing keeps the order") {
+        bool erased = true;
+        for (int i = 0; i < 1000; i += 2) {
+            erased = tree.erase(i) && erased;
+        }
+        CHECK(erased);
+        CHECK_FALSE(tree.erase(0));
+        CHECK(tree.size() == 500);
+        CHECK(tree[0] == 1);
+        CHECK(tree[499] == 999);
+        CHECK_FALSE(tree.contains(998));
+    }
+
+    SUBCASE("Blocks cover every rank once") {
+        StorageBlock<int> block;
+        size_t rank = 0;
+        bool consecutive = true;
+        while (rank < tree.size()) {
+            block = tree.blockFor(rank, block);
+            consecutive = consecutive && block.start == rank && block.items.front() == static_cast<int>(rank);
+            rank += block.items.size();
+        }
+        CHECK(consecutive);
+        CHECK(rank == 1000);
+    }
+
+    SUBCASE("Leaves stay at least half full while erasing") {
+        // Erase 90% of the elements in a scattered order, every leaf of the result must still hold half a leaf
+        vector<int> kept;
+        bool erased = true;
+        for (int i = 0; i < 1000; ++i) {
+            int value = (i * 37) % 1000;
+            if (value % 10 == 3) {
+                kept.push_back(value);
+            } else {
+                erased = tree.erase(value) && erased;
+            }
+        }
+        CHECK(erased);
+        sort(kept.begin(), kept.end());
+        CHECK(tree.size() == kept.size());
+
+        StorageBlock<int> block;
+        vector<int> scanned;
+        bool halfFull = true;
+        while (scanned.size() < tree.size()) {
+            block = tree.blockFor(scanned.size(), block);
+            halfFull = halfFull && block.items.size() >= BPlusTree<int>::LeafCapacity / 2;
+            scanned.insert(scanned.end(), block.items.begin(), block.items.end());
+        }
+        CHECK(halfFull);
+        CHECK(scanned == kept);
+        CHECK(tree.lowerBound(503) == 50);
+        CHECK(tree.contains(993));
+
+        for (int value : kept) {
+            erased = tree.erase(value) && erased;
+        }
+        CHECK(erased);
+        CHECK(tree.empty());
+        CHECK(tree.insert(7));
+        CHECK(tree[0] == 7);
+    }
+
+    SUBCASE("Bulk merge and erase") {
+        tree.merge(vector<int>{1000, 1001, 1002});
+        CHECK(tree.size() == 1003);
+        tree.eraseAll(vector<int>{0, 1001, 5000});
+        CHECK(tree.size() == 1001);
+        CHECK(tree[0] == 1);
+        CHECK(tree.back() == 1002);
+    }
+}
+
+TEST_CASE_TEMPLATE("Iterating a container larger than one storage block", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    for (int i = 1; i <= 300; ++i) {
+        container.addElement(i);
+    }
+
+    int expected = 1;
+    bool ascending = true;
+    typename Container::AscendingIterator asc(container);
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        ascending = ascending && *it == expected++;
+    }
+    CHECK(ascending);
+
+    typename Container::SideCrossIterator cross(container);
+    auto it = cross.begin();
+    for (int i = 0; i < 100; ++i) {
+        ++it;
+    }
+    CHECK(*it == 51);
+    container.removeElement(51);
+    CHECK(*it == 52);
+
+    typename Container::PrimeIterator prime(container);
+    CHECK(*prime == 2);
+    container.removeElements(vector<int>{2, 3});
+    CHECK(*prime == 5);
+}
+
+// A storage policy from outside the library, the flat vector counting the single inserts it gets
+template <typename T>
+class CountingStorage : public SortedVector<T> {
+public:
+    static inline int inserts = 0;
+
+    bool insert(const T &value) {
+        ++inserts;
+        return SortedVector<T>::insert(value);
+    }
+};
+
+TEST_CASE("Container over a storage policy of the user") {
+    BasicMagicalContainer<int, CountingStorage> container;
+    container.addElement(4);
+    container.addElement(7);
+    container.addElements(vector<int>{1, 2, 3});
+    CHECK(CountingStorage<int>::inserts == 3); // 4, 7 and the prime 7, the batch is merged
+    CHECK(container.size() == 5);
+
+    vector<int> cross;
+    BasicMagicalContainer<int, CountingStorage>::SideCrossIterator it(container);
+    for (auto current = it.begin(); current != it.end(); ++current) {
+        cross.push_back(*current);
+    }
+    CHECK(cross == vector<int>{1, 7, 2, 4, 3});
+}
+
+static_assert(isPrime<int16_t>(32749) && !isPrime<int16_t>(-7));
+static_assert(isPrime<uint32_t>(4294967291U) && !isPrime<uint32_t>(4294967295U));
+
+TEST_CASE_TEMPLATE("Containers of other element widths", T, int16_t, uint32_t, int64_t) {
+    BasicMagicalContainer<T> container;
+    container.addElements(vector<T>{9, 2, 25, 17, 3, numeric_limits<T>::max()});
+    CHECK(container.size() == 6);
+
+    vector<T> ascending;
+    typename BasicMagicalContainer<T>::AscendingIterator asc(container);
+    for (auto it = asc.begin(); it != asc.end(); ++it) {
+        ascending.push_back(*it);
+    }
+    CHECK(ascending == vector<T>{2, 3, 9, 17, 25, numeric_limits<T>::max()});
+
+    typename BasicMagicalContainer<T>::SideCrossIterator cross(container);
+    ++cross;
+    CHECK(*cross == numeric_limits<T>::max());
+
+    // The biggest value of each width is composite: 2^15-1, 2^32-1 and 2^63-1
+    vector<T> primes;
+    typename BasicMagicalContainer<T>::PrimeIterator prime(container);
+    for (auto it = prime.begin(); it != prime.end(); ++it) {
+        primes.push_back(*it);
+    }
+    CHECK(primes == vector<T>{2, 3, 17});
+}
+
+TEST_CASE("64-bit elements beyond the range of int") {
+    BasicMagicalContainer<int64_t, BPlusTree> container;
+    container.addElement(4294967311);   // The first prime after 2^32
+    container.addElement(4294967297);   // 641 * 6700417
+    container.addElement(-4294967311);
+
+    BasicMagicalContainer<int64_t, BPlusTree>::AscendingIterator asc(container);
+    CHECK(*asc == -4294967311);
+
+    BasicMagicalContainer<int64_t, BPlusTree>::PrimeIterator prime(container);
+    CHECK(*prime == 4294967311);
+    ++prime;
+    CHECK(prime == prime.end());
+}
+
+TEST_CASE("Primality across the full value range") {
+    // Strong pseudoprimes to the small bases, Miller-Rabin with a weaker witness set accepts them
+    CHECK_FALSE(isPrime<int64_t>(3215031751));
+    CHECK_FALSE(isPrime<int64_t>(4759123141));
+    CHECK_FALSE(isPrime<int64_t>(3825123056546413051));
+    CHECK_FALSE(isPrime<uint32_t>(4294967295U));
+    CHECK_FALSE(isPrime(46337 * 46327)); // The two biggest primes below the square root of INT_MAX
+
+    CHECK(isPrime(2147483647));
+    CHECK(isPrime<uint32_t>(4294967291U));
+    CHECK(isPrime<int64_t>(9223372036854775783));
+    CHECK(isPrime<uint64_t>(18446744073709551557ULL));
+
+    int mismatches = 0;
+    for (int number = -10; number < 10000; ++number) {
+        bool divisible = number < 2;
+        for (int divisor = 2; divisor * divisor <= number && !divisible; ++divisor) {
+            divisible = number % divisor == 0;
+        }
+        mismatches += (isPrime(number) == divisible) ? 1 : 0;
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("Shared prime sieve") {
+    PrimeSieve &sieve = PrimeSieve::shared();
+    CHECK(&sieve == &PrimeSieve::shared());
+
+    SUBCASE("Agrees with Miller-Rabin across segment borders") {
+        int mismatches = 0;
+        for (uint64_t segment = 1; segment <= 3; ++segment) {
+            uint64_t border = segment * PrimeSieve::SegmentSpan;
+            for (uint64_t number = border - 500; number < border + 500; ++number) {
+                bool composite = number % 2 == 0;
+                if (!composite) {
+                    composite = !millerRabin(static_cast<uint32_t>(number), Witnesses32);
+                }
+                mismatches += (sieve.isPrime(number) == composite) ? 1 : 0;
+            }
+        }
+        CHECK(mismatches == 0);
+        for (size_t segment = 0; segment < 4; ++segment) {
+            CHECK(sieve.sieved(segment));
+        }
+    }
+
+    SUBCASE("A value sieves its own segment only") {
+        const size_t last = PrimeSieve::MaxSegments - 1;
+        size_t before = sieve.sievedCount();
+        bool wasSieved = sieve.sieved(last);
+        CHECK(sieve.isPrime(33554393));
+        CHECK(sieve.sieved(last));
+        CHECK(sieve.sievedCount() == before + (wasSieved ? 0 : 1));
+    }
+
+    SUBCASE("Threads growing it at the same time") {
+        vector<size_t> counts(4, 0);
+        vector<thread> threads;
+        for (size_t worker = 0; worker < counts.size(); ++worker) {
+            threads.emplace_back([&counts, worker]() {
+                // Every thread walks the same values, in a different order
+                for (uint64_t step = 0; step < 8; ++step) {
+                    uint64_t segment = (step + worker) % 8;
+                    counts[worker] += PrimeSieve::shared().isPrime(segment * PrimeSieve::SegmentSpan + 1) ? 1U : 0U;
+                }
+            });
+        }
+        for (thread &worker : threads) {
+            worker.join();
+        }
+        CHECK(count(counts.begin(), counts.end(), counts[0]) == 4);
+        for (size_t segment = 0; segment < 8; ++segment) {
+            CHECK(PrimeSieve::shared().sieved(segment));
+        }
+    }
+}
+
+static_assert(SmallPrimes.front() == 2 && SmallPrimes.back() == 65521);
+static_assert(isPrime(65521) && !isPrime(65535) && isPrime(65537));
+
+TEST_CASE("Compile-time prime table and wheel") {
+    size_t inTable = 0;
+    for (uint32_t number = 0; number < SmallPrimeLimit; ++number) {
+        inTable += isSmallPrime(number) ? 1U : 0U;
+    }
+    CHECK(inTable == SmallPrimeCount);
+
+    size_t coprime = 0;
+    for (bool spoke : WheelCoprime) {
+        coprime += spoke ? 1U : 0U;
+    }
+    CHECK(coprime == 48);
+
+    // Past the table the wheel rejects the multiples of 2, 3, 5 and 7 on its own
+    CHECK_FALSE(isPrime(7 * 9377));
+    CHECK_FALSE(isPrime<int64_t>(7 * 1000000000039LL));
+    CHECK(isPrime(65537));
+}
+
+TEST_CASE_TEMPLATE("Batched prime classification", T, int16_t, int, uint32_t, int64_t) {
+    // 1003 values, so the last block of eight lanes is only partly full
+    vector<T> values;
+    for (int i = -20; i < 983; ++i) {
+        values.push_back(static_cast<T>(static_cast<T>(i) * static_cast<T>(31)));
+    }
+    values.push_back(numeric_limits<T>::max());
+    values.push_back(static_cast<T>(61));
+
+    PrimeBits bits;
+    classifyPrimes(span<const T>(values), bits);
+    REQUIRE(bits.size() == (values.size() + 63) / 64);
+
+    int mismatches = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        mismatches += (testPrimeBit(bits, i) != isPrime(values[i])) ? 1 : 0;
+    }
+    CHECK(mismatches == 0);
+    CHECK(testPrimeBit(bits, values.size() - 1));
+}
+
+TEST_CASE("Bulk load feeds the prime index through the classifier") {
+    vector<int> batch;
+    for (int i = 1; i <= 5000; ++i) {
+        batch.push_back(i);
+    }
+    MagicalContainer container;
+    container.addElements(batch);
+
+    int primes = 0;
+    MagicalContainer::PrimeIterator prime(container);
+    for (auto it = prime.begin(); it != prime.end(); ++it) {
+        ++primes;
+    }
+    CHECK(primes == 669); // The primes below 5000
+}
+
+TEST_CASE_TEMPLATE("Random access on AscendingIterator", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    vector<int> batch;
+    for (int i = 0; i < 1000; ++i) {
+        batch.push_back(i * 10);
+    }
+    container.addElements(batch);
+
+    typename Container::AscendingIterator asc(container);
+    auto begin = asc.begin();
+    auto end = asc.end();
+    CHECK(end - begin == 1000);
+
+    SUBCASE("Legacy algorithms jump instead of walking") {
+        CHECK(std::distance(begin, end) == 1000);
+        auto found = std::lower_bound(begin, end, 4321);
+        CHECK(*found == 4330);
+        CHECK(std::distance(begin, found) == 433);
+        CHECK(std::upper_bound(begin, end, 9990) == end);
+    }
+
+    SUBCASE("Paging by offset") {
+        auto page = begin + 500;
+        CHECK(*page == 5000);
+        CHECK(page[99] == 5990);
+        CHECK(page[-500] == 0);
+        CHECK(page - begin == 500);
+        CHECK(*(2 + page) == 5020);
+
+        page -= 100;
+        CHECK(*page == 4000);
+        --page;
+        CHECK(*page == 3990);
+        page += 600;
+        CHECK(*page == 9990);
+        CHECK(page + 1 == end);
+        CHECK(*(end - 1) == 9990);
+    }
+
+    SUBCASE("Moving out of the container throws") {
+        CHECK_THROWS_AS(begin - 1, runtime_error);
+        CHECK_THROWS_AS(begin + 1001, runtime_error);
+        CHECK_THROWS_AS(begin[1000], runtime_error);
+        CHECK_THROWS_AS(--begin, runtime_error);
+        CHECK_THROWS_AS(begin -= PTRDIFF_MIN, runtime_error);
+        CHECK(*begin == 0);
+    }
+
+    SUBCASE("Offsets count from the element after the container changed") {
+        auto it = begin + 10;
+        container.removeElements(vector<int>{0, 10, 20});
+        CHECK(*it == 100);
+        CHECK(it - asc.begin() == 7);
+        CHECK(it[3] == 130);
+    }
+
+    SUBCASE("Binary search over the iterators") {
+        auto low = begin;
+        ptrdiff_t count = end - begin;
+        while (count > 0) {
+            ptrdiff_t half = count / 2;
+            if (low[half] < 4321) {
+                low += half + 1;
+                count -= half + 1;
+            } else {
+                count = half;
+            }
+        }
+        CHECK(*low == 4330);
+    }
+}
+
+TEST_CASE_TEMPLATE("Prime count and random access on PrimeIterator", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    vector<int> batch;
+    for (int i = 1; i <= 10000; ++i) {
+        batch.push_back(i);
+    }
+    container.addElements(batch);
+    CHECK(container.primeCount() == 1229);
+
+    typename Container::PrimeIterator prime(container);
+    auto begin = prime.begin();
+    CHECK(prime.end() - begin == 1229);
+    CHECK(begin[999] == 7919); // The 1000th prime
+    CHECK(*(begin + 1228) == 9973);
+
+    auto it = begin + 100;
+    CHECK(*it == 547);
+    it -= 99;
+    CHECK(*it == 3);
+    --it;
+    CHECK(*it == 2);
+    CHECK_THROWS_AS(--it, runtime_error);
+    CHECK_THROWS_AS(it[1229], runtime_error);
+
+    container.removeElements(vector<int>{2, 3, 5});
+    CHECK(container.primeCount() == 1226);
+    CHECK(*it == 7);
+    CHECK(it[996] == 7919);
+}
+
+static_assert(random_access_iterator<MagicalContainer::AscendingIterator>);
+static_assert(forward_iterator<MagicalContainer::SideCrossIterator>);
+static_assert(random_access_iterator<MagicalContainer::PrimeIterator>);
+static_assert(random_access_iterator<BasicMagicalContainer<int64_t, BPlusTree>::PrimeIterator>);
+static_assert(same_as<iter_reference_t<MagicalContainer::AscendingIterator>, int>);
+// The std:: algorithms of before C++20 dispatch on iterator_category, not on iterator_concept
+static_assert(same_as<iterator_traits<MagicalContainer::AscendingIterator>::iterator_category, random_access_iterator_tag>);
+static_assert(same_as<iterator_traits<MagicalContainer::PrimeIterator>::iterator_category, random_access_iterator_tag>);
+static_assert(same_as<iterator_traits<MagicalContainer::SideCrossIterator>::iterator_category, bidirectional_iterator_tag>);
+static_assert(same_as<iterator_traits<MagicalContainer::FilterIterator<IsEven>>::iterator_category, bidirectional_iterator_tag>);
+static_assert(ranges::random_access_range<MagicalContainer::AscendingIterator>);
+
+TEST_CASE("Iterators work with the standard algorithms and views") {
+    MagicalContainer container;
+    container.addElements(vector<int>{17, 2, 25, 9, 3, 40, 11});
+
+    MagicalContainer::AscendingIterator asc(container);
+    MagicalContainer::SideCrossIterator cross(container);
+    MagicalContainer::PrimeIterator prime(container);
+
+    SUBCASE("Ranges algorithms on an iterator and its end") {
+        CHECK(*ranges::lower_bound(asc, 10) == 11);
+        CHECK(ranges::distance(asc) == 7);
+        CHECK(ranges::binary_search(prime.begin(), prime.end(), 17));
+        CHECK(*ranges::max_element(cross) == 40);
+        CHECK(ranges::is_sorted(asc));
+    }
+
+    SUBCASE("Views") {
+        vector<int> largestPrimes;
+        for (int element : prime | views::reverse | views::take(2)) {
+            largestPrimes.push_back(element);
+        }
+        CHECK(largestPrimes == vector<int>{17, 11});
+
+        vector<int> firstCross;
+        ranges::copy(cross | views::take(3), back_inserter(firstCross));
+        CHECK(firstCross == vector<int>{2, 40, 3});
+    }
+
+    SUBCASE("Numeric algorithms") {
+        CHECK(reduce(asc.begin(), asc.end()) == 107);
+        CHECK(accumulate(prime.begin(), prime.end(), 0) == 33);
+    }
+
+    SUBCASE("Postfix steps and default constructed iterators") {
+        auto it = asc.begin();
+        CHECK(*it++ == 2);
+        CHECK(*it == 3);
+        CHECK(*it-- == 3);
+        CHECK(*it == 2);
+
+        MagicalContainer::AscendingIterator unattached;
+        unattached = it;
+        CHECK(*unattached == 2);
+        MagicalContainer other;
+        MagicalContainer::AscendingIterator foreign(other);
+        CHECK_THROWS_AS(unattached = foreign, runtime_error);
+    }
+}
+
+static_assert(bidirectional_iterator<MagicalContainer::SideCrossIterator>);
+
+TEST_CASE("Reverse traversal of every iterator kind") {
+    MagicalContainer container;
+    container.addElements(vector<int>{17, 2, 25, 9, 3, 40, 11});
+
+    SUBCASE("Largest elements first") {
+        MagicalContainer::AscendingIterator asc(container);
+        vector<int> topThree;
+        for (auto it = asc.rbegin(); it != asc.rbegin() + 3; ++it) {
+            topThree.push_back(*it);
+        }
+        CHECK(topThree == vector<int>{40, 25, 17});
+        CHECK(asc.rend() - asc.rbegin() == 7);
+    }
+
+    SUBCASE("Cross order backwards") {
+        MagicalContainer::SideCrossIterator cross(container);
+        vector<int> backwards(cross.rbegin(), cross.rend());
+        CHECK(backwards == vector<int>{11, 17, 9, 25, 3, 40, 2});
+
+        auto it = cross.end();
+        --it;
+        CHECK(*it == 11);
+        CHECK(*it-- == 11);
+        CHECK(*it == 17);
+        CHECK_THROWS_AS(--cross.begin(), runtime_error);
+    }
+
+    SUBCASE("Primes from the biggest down") {
+        MagicalContainer::PrimeIterator prime(container);
+        auto it = prime.rbegin();
+        CHECK(*it == 17);
+        ++it;
+        CHECK(*it == 11);
+        CHECK(vector<int>(prime.rbegin(), prime.rend()) == vector<int>{17, 11, 3, 2});
+    }
+}
+
+static_assert(bidirectional_iterator<MagicalContainer::FilterIterator<IsEven>>);
+
+TEST_CASE_TEMPLATE("Filtered views of the elements", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    vector<int> values(2000);
+    iota(values.begin(), values.end(), -500);
+    container.addElements(values);
+
+    auto expected = [&](auto predicate) {
+        vector<int> matching;
+        copy_if(values.begin(), values.end(), back_inserter(matching), predicate);
+        return matching;
+    };
+
+    SUBCASE("Scanned and indexed predicates see the same elements") {
+        typename Container::template FilterIterator<IsEven> even(container);
+        CHECK(vector<int>(even.begin(), even.end()) == expected(IsEven{}));
+
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        CHECK(vector<int>(squares.begin(), squares.end()) == expected(IsPerfectSquare{}));
+
+        typename Container::template FilterIterator<InBitmask<0b101010>> masked(container);
+        CHECK(vector<int>(masked.begin(), masked.end()) == vector<int>{1, 3, 5});
+    }
+
+    SUBCASE("Indexes follow every change") {
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        container.addElement(4096);
+        container.addElements(vector<int>{10000, 10001});
+        container.removeElement(25);
+        container.removeElements(vector<int>{0, 1, 2});
+        vector<int> found(squares.begin(), squares.end());
+        CHECK(found.front() == 4);
+        CHECK(found.back() == 10000);
+        CHECK(ranges::count(found, 4096) == 1);
+        CHECK(ranges::count(found, 25) == 0);
+
+        Container copy(container);
+        typename Container::template FilterIterator<IsPerfectSquare> copied(copy);
+        CHECK(vector<int>(copied.begin(), copied.end()) == found);
+
+        Container assigned;
+        typename Container::template FilterIterator<IsPerfectSquare> before(assigned);
+        assigned = container;
+        CHECK(vector<int>(before.begin(), before.end()) == found);
+    }
+
+    SUBCASE("An iterator whose element is removed moves to the next accepted one") {
+        typename Container::template FilterIterator<IsEven> even(container);
+        auto scanned = even.begin();
+        ++scanned;
+        CHECK(*scanned == -498);
+        container.removeElement(-498);
+        CHECK(*scanned == -496);
+
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        auto indexed = squares.begin();
+        ++indexed;
+        CHECK(*indexed == 1);
+        container.removeElement(1);
+        CHECK(*indexed == 4);
+    }
+
+    SUBCASE("Walking backwards") {
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        auto largest = squares.rbegin();
+        CHECK(*largest == 1444);
+        CHECK(*++largest == 1369);
+
+        typename Container::template FilterIterator<IsEven> even(container);
+        auto it = even.end();
+        --it;
+        CHECK(*it == 1498);
+        CHECK_THROWS_AS(--even.begin(), runtime_error);
+    }
+}
+
+TEST_CASE_TEMPLATE("Batched iteration", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    vector<int> values(3000);
+    iota(values.begin(), values.end(), 1);
+    container.addElements(values);
+
+    // Drains the iterator in batches of batchSize and checks it agrees with stepping one element at a time
+    auto drain = [](auto iterator, size_t batchSize) {
+        vector<int> batched;
+        vector<int> buffer(batchSize);
+        while (size_t count = iterator.nextBatch(buffer)) {
+            batched.insert(batched.end(), buffer.begin(), buffer.begin() + static_cast<ptrdiff_t>(count));
+        }
+        CHECK(iterator == iterator.end());
+        return batched;
+    };
+
+    for (size_t batchSize : {1U, 7U, 64U, 5000U}) {
+        typename Container::AscendingIterator asc(container);
+        CHECK(drain(asc.begin(), batchSize) == vector<int>(asc.begin(), asc.end()));
+
+        typename Container::SideCrossIterator cross(container);
+        CHECK(drain(cross.begin(), batchSize) == vector<int>(cross.begin(), cross.end()));
+
+        typename Container::PrimeIterator prime(container);
+        CHECK(drain(prime.begin(), batchSize) == vector<int>(prime.begin(), prime.end()));
+
+        typename Container::template FilterIterator<IsEven> even(container);
+        CHECK(drain(even.begin(), batchSize) == vector<int>(even.begin(), even.end()));
+
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        CHECK(drain(squares.begin(), batchSize) == vector<int>(squares.begin(), squares.end()));
+    }
+
+    SUBCASE("A batch leaves the iterator on the next element") {
+        typename Container::SideCrossIterator cross(container);
+        auto it = cross.begin();
+        vector<int> buffer(3);
+        CHECK(it.nextBatch(buffer) == 3);
+        CHECK(buffer == vector<int>{1, 3000, 2});
+        CHECK(*it == 2999);
+
+        typename Container::template FilterIterator<IsEven> even(container);
+        auto evenIt = even.begin();
+        CHECK(evenIt.nextBatch(buffer) == 3);
+        CHECK(buffer == vector<int>{2, 4, 6});
+        CHECK(*evenIt == 8);
+    }
+
+    SUBCASE("Batches after a change continue from the anchored element") {
+        typename Container::AscendingIterator asc(container);
+        auto it = asc.begin();
+        vector<int> buffer(10);
+        it.nextBatch(buffer);
+        container.removeElements(vector<int>{11, 12});
+        CHECK(it.nextBatch(buffer) == 10);
+        CHECK(buffer.front() == 13);
+        CHECK(buffer.back() == 22);
+    }
+
+    SUBCASE("Empty containers and unattached iterators") {
+        Container empty;
+        typename Container::PrimeIterator prime(empty);
+        vector<int> buffer(4);
+        CHECK(prime.nextBatch(buffer) == 0);
+        typename Container::AscendingIterator unattached;
+        CHECK(unattached.nextBatch(buffer) == 0);
+    }
+}
+
+TEST_CASE_TEMPLATE("Splitting iterators and parallel traversal", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container;
+    vector<int> values(5000);
+    iota(values.begin(), values.end(), 1);
+    container.addElements(values);
+
+    // Joins the ranges back together and checks their sizes
+    auto join = [](const auto &ranges) {
+        vector<int> joined;
+        for (const auto &range : ranges) {
+            vector<int> part(range.begin(), range.end());
+            CHECK(part.size() == range.size());
+            joined.insert(joined.end(), part.begin(), part.end());
+        }
+        return joined;
+    };
+
+    SUBCASE("The ranges cover the traversal in order") {
+        typename Container::AscendingIterator asc(container);
+        auto ascRanges = asc.split(7);
+        CHECK(ascRanges.size() == 7);
+        CHECK(ascRanges.front().size() == 714);
+        CHECK(ascRanges.back().size() == 715);
+        CHECK(join(ascRanges) == values);
+
+        typename Container::SideCrossIterator cross(container);
+        CHECK(join(cross.split(3)) == vector<int>(cross.begin(), cross.end()));
+
+        typename Container::PrimeIterator prime(container);
+        CHECK(join(prime.split(5)) == vector<int>(prime.begin(), prime.end()));
+
+        typename Container::template FilterIterator<IsPerfectSquare> squares(container);
+        CHECK(join(squares.split(4)) == vector<int>(squares.begin(), squares.end()));
+    }
+
+    SUBCASE("Only what is left is split") {
+        typename Container::AscendingIterator asc(container);
+        auto ranges = (asc.begin() + 4990).split(20);
+        CHECK(ranges.size() == 20);
+        CHECK(ranges.front().empty());
+        CHECK(join(ranges) == vector<int>{4991, 4992, 4993, 4994, 4995, 4996, 4997, 4998, 4999, 5000});
+        CHECK_THROWS_AS(asc.split(0), invalid_argument);
+        CHECK_THROWS_AS(typename Container::AscendingIterator().split(2), runtime_error);
+    }
+
+    SUBCASE("Every element is visited exactly once") {
+        long long expected = accumulate(values.begin(), values.end(), 0LL);
+        for (unsigned threads : {1U, 3U, 8U}) {
+            atomic<long long> sum(0);
+            atomic<int> visits(0);
+            parallelForEach(typename Container::SideCrossIterator(container), [&](int element) {
+                sum += element;
+                ++visits;
+            }, threads);
+            CHECK(sum == expected);
+            CHECK(visits == 5000);
+        }
+
+        typename Container::PrimeIterator prime(container);
+        atomic<long long> primeSum(0);
+        parallelForEach(prime, [&](int element) { primeSum += element; }, 4);
+        CHECK(primeSum == accumulate(prime.begin(), prime.end(), 0LL));
+    }
+
+    SUBCASE("An exception reaches the caller") {
+        auto failing = [](int element) {
+            if (element == 2500) {
+                throw runtime_error("Bad element");
+            }
+        };
+        CHECK_THROWS_AS(parallelForEach(typename Container::AscendingIterator(container), failing, 4), runtime_error);
+    }
+}
+
+TEST_CASE_TEMPLATE("Shared containers with concurrent readers and writers", Container, BasicMagicalContainer<int, SortedVector>, BasicMagicalContainer<int, BPlusTree>) {
+    Container container(Threading::Shared);
+    vector<int> evens(5000);
+    for (size_t i = 0; i < evens.size(); ++i) {
+        evens[i] = 2 * static_cast<int>(i);
+    }
+    container.addElements(evens);
+
+    // Every reader walks on its own iterators and must see ascending values while the writer works
+    atomic<int> disorders(0);
+    auto batchReader = [&]() {
+        for (int pass = 0; pass < 20; ++pass) {
+            typename Container::AscendingIterator asc(container);
+            vector<int> buffer(64);
+            int previous = numeric_limits<int>::min();
+            while (size_t count = asc.nextBatch(buffer)) {
+                for (size_t i = 0; i < count; ++i) {
+                    if (buffer[i] <= previous) {
+                        ++disorders;
+                    }
+                    previous = buffer[i];
+                }
+            }
+        }
+    };
+
+    // Dereferences element by element while the writer moves and removes the elements under it.
+    // The evens from 10 up are never removed, so every pass sees all of them
+    atomic<int> skips(0);
+    auto stepReader = [&]() {
+        for (int pass = 0; pass < 5; ++pass) {
+            typename Container::AscendingIterator asc(container);
+            long long previous = numeric_limits<long long>::min();
+            int kept = 0;
+            for (auto it = asc.begin(); it != asc.end(); ++it) {
+                int value = *it;
+                if (value <= previous) {
+                    ++disorders;
+                }
+                if (value >= 10 && value % 2 == 0) {
+                    ++kept;
+                }
+                previous = value;
+            }
+            if (kept != 4995) {
+                ++skips;
+            }
+
+            typename Container::PrimeIterator prime(container);
+            previous = -1;
+            for (auto it = prime.begin(); it != prime.end(); it++) {
+                if (*it <= previous) {
+                    ++disorders;
+                }
+                previous = *it;
+            }
+        }
+    };
+
+    // Inserting in front of everything moves every element of the flat vector
+    auto writer = [&]() {
+        for (int odd = 1; odd < 2000; odd += 2) {
+            container.addElement(-odd);
+            container.addElement(odd);
+            container.removeElement(odd);
+            container.addElement(odd);
+        }
+        container.removeElements(vector<int>{0, 2, 4, 6, 8});
+    };
+
+    vector<thread> threads;
+    threads.emplace_back(batchReader);
+    threads.emplace_back(batchReader);
+    threads.emplace_back(stepReader);
+    threads.emplace_back(stepReader);
+    threads.emplace_back(writer);
+    for (thread &worker : threads) {
+        worker.join();
+    }
+
+    CHECK(disorders == 0);
+    CHECK(skips == 0);
+    CHECK(container.size() == 5000 + 2000 - 5);
+
+    typename Container::AscendingIterator asc(container);
+    CHECK(*asc == -1999);
+    CHECK(ranges::is_sorted(asc));
+
+    Container copy(container);
+    CHECK(copy.size() == container.size());
+}
+
+TEST_CASE("Iterators registered on several threads") {
+    using Iterator = MagicalContainer::AscendingIterator;
+    auto container = make_unique<MagicalContainer>(Threading::Shared);
+    container->addElements(vector<int>{1, 2, 3});
+
+    // Every thread keeps some of its iterators and drops the others, half of the kept ones are dropped on another thread
+    vector<vector<unique_ptr<Iterator>>> kept(4);
+    vector<thread> threads;
+    for (size_t worker = 0; worker < kept.size(); ++worker) {
+        threads.emplace_back([&, worker]() {
+            Iterator asc(*container);
+            for (int i = 0; i < 1000; ++i) {
+                Iterator copy = asc;
+                if (i % 100 == 0) {
+                    kept[worker].push_back(make_unique<Iterator>(copy));
+                }
+            }
+        });
+    }
+    for (thread &worker : threads) {
+        worker.join();
+    }
+
+    threads.clear();
+    for (size_t worker = 0; worker < kept.size(); ++worker) {
+        threads.emplace_back([&, worker]() {
+            kept[(worker + 1) % kept.size()].resize(5);
+        });
+    }
+    for (thread &worker : threads) {
+        worker.join();
+    }
+
+    for (vector<unique_ptr<Iterator>> &iterators : kept) {
+        REQUIRE(iterators.size() == 5);
+        for (unique_ptr<Iterator> &it : iterators) {
+            CHECK(**it == 1);
+        }
+    }
+
+    // The container finds the iterators of every thread to detach them
+    container.reset();
+    for (vector<unique_ptr<Iterator>> &iterators : kept) {
+        for (unique_ptr<Iterator> &it : iterators) {
+            CHECK_THROWS_AS(**it, runtime_error);
+        }
+    }
+}
+
+TEST_CASE("Read mostly lock") {
+    ReadMostlyLock lock;
+    {
+        shared_lock<ReadMostlyLock> reader(lock);
+        CHECK_FALSE(lock.try_lock());
+
+        // Another reader gets in, from another thread since a thread must not read lock twice
+        bool otherReader = false;
+        thread([&]() {
+            shared_lock<ReadMostlyLock> second(lock, try_to_lock);
+            otherReader = second.owns_lock();
+        }).join();
+        CHECK(otherReader);
+    }
+
+    unique_lock<ReadMostlyLock> writer(lock, try_to_lock);
+    REQUIRE(writer.owns_lock());
+    CHECK_FALSE(lock.try_lock_shared());
+    writer.unlock();
+    CHECK(lock.try_lock_shared());
+    lock.unlock_shared();
+}
+
+TEST_CASE("Element by element traversal of a shared container while an element comes and goes") {
+    MagicalContainer container(Threading::Shared);
+    vector<int> values(71);
+    iota(values.begin(), values.end(), 0);
+    container.addElements(values);
+
+    atomic<bool> done(false);
+    thread writer([&]() {
+        for (int i = 0; i < 2000; ++i) {
+            container.addElement(1000);
+            this_thread::yield();
+            container.removeElement(1000);
+            this_thread::yield();
+        }
+        done = true;
+    });
+
+    // An exception escaping a thread would terminate, so failures are counted instead
+    int failures = 0;
+    int passes = 0;
+    while (!done || passes < 10) {
+        try {
+            MagicalContainer::AscendingIterator asc(container);
+            int sum = 0;
+            for (auto it = asc.begin(); it != asc.end(); ++it) {
+                int value = *it;
+                sum += (value < 1000) ? value : 0;
+
+                // Lets the writer in between the read and the step, even on a single core
+                this_thread::yield();
+            }
+            failures += (sum == 70 * 71 / 2) ? 0 : 1;
+        } catch (const runtime_error &) {
+            ++failures;
+        }
+        ++passes;
+    }
+    writer.join();
+    CHECK(failures == 0);
+}
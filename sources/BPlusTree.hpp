@@ -0,0 +1,719 @@
+#ifndef B_PLUS_TREE_HPP
+#define B_PLUS_TREE_HPP
+#include "StorageBlock.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace ariel
+{
+    // Blocked storage: a B+ tree of small sorted leaves. Inner nodes count the elements under each child,
+    // so search, access by rank, insert and erase are all O(log n) and move at most one leaf of elements.
+    // The leaves are linked both ways, so scans in either direction step from leaf to leaf in O(1).
+    template <typename T>
+    class BPlusTree
+    {
+    public:
+        using Block = StorageBlock<T>;
+
+        // The elements of a leaf fill one cache line
+        static constexpr size_t LeafCapacity = (64 / sizeof(T) < 8) ? 8 : 64 / sizeof(T);
+        static constexpr size_t Fanout = 16;
+
+    private:
+        struct Node
+        {
+            bool leaf;
+            size_t count; // Elements in a leaf, children in an inner node
+        };
+
+        // The header and the links sit in the cache line before the elements, so the elements start a line of their own
+        struct Leaf : Node
+        {
+            Leaf *previous;
+            Leaf *next;
+            alignas(64) T items[LeafCapacity];
+        };
+
+        struct Inner : Node
+        {
+            Node *children[Fanout];
+            size_t sizes[Fanout]; // Number of elements under each child
+            T keys[Fanout - 1];   // keys[i] is bigger than everything under children[i] and not bigger than anything under children[i + 1]
+        };
+
+        // A node that split while inserting, right goes after the node that split and key separates them
+        struct Split
+        {
+            Node *right = nullptr;
+            T key{};
+        };
+
+        Node *root;
+        size_t total;
+
+        static Leaf *newLeaf()
+        {
+            Leaf *leaf = new Leaf;
+            leaf->leaf = true;
+            leaf->count = 0;
+            leaf->previous = nullptr;
+            leaf->next = nullptr;
+            return leaf;
+        }
+
+        static Inner *newInner()
+        {
+            Inner *inner = new Inner;
+            inner->leaf = false;
+            inner->count = 0;
+            return inner;
+        }
+
+        static Leaf *asLeaf(Node *node) { return static_cast<Leaf *>(node); }
+        static const Leaf *asLeaf(const Node *node) { return static_cast<const Leaf *>(node); }
+        static Inner *asInner(Node *node) { return static_cast<Inner *>(node); }
+        static const Inner *asInner(const Node *node) { return static_cast<const Inner *>(node); }
+
+        static void destroy(Node *node)
+        {
+            if (!node->leaf)
+            {
+                Inner *inner = asInner(node);
+                for (size_t i = 0; i < inner->count; ++i)
+                {
+                    destroy(inner->children[i]);
+                }
+                delete inner;
+            }
+            else
+            {
+                delete asLeaf(node);
+            }
+        }
+
+        static size_t sizeOf(const Node *node)
+        {
+            if (node->leaf)
+            {
+                return node->count;
+            }
+
+            const Inner *inner = asInner(node);
+            size_t sum = 0;
+            for (size_t i = 0; i < inner->count; ++i)
+            {
+                sum += inner->sizes[i];
+            }
+            return sum;
+        }
+
+        // The child of an inner node that holds value, or would hold it
+        static size_t childFor(const Inner *inner, const T &value)
+        {
+            return static_cast<size_t>(std::upper_bound(inner->keys, inner->keys + inner->count - 1, value) - inner->keys);
+        }
+
+        const Leaf *leftmostLeaf() const
+        {
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                node = asInner(node)->children[0];
+            }
+            return asLeaf(node);
+        }
+
+        bool insertInto(Node *node, const T &value, Split &split)
+        {
+            if (node->leaf)
+            {
+                return insertIntoLeaf(asLeaf(node), value, split);
+            }
+
+            Inner *inner = asInner(node);
+            size_t child = childFor(inner, value);
+
+            Split childSplit;
+            if (!insertInto(inner->children[child], value, childSplit))
+            {
+                return false;
+            }
+
+            if (childSplit.right == nullptr)
+            {
+                ++inner->sizes[child];
+                return true;
+            }
+
+            inner->sizes[child] = sizeOf(inner->children[child]);
+            insertChild(inner, child + 1, childSplit, split);
+            return true;
+        }
+
+        static bool insertIntoLeaf(Leaf *leaf, const T &value, Split &split)
+        {
+            size_t position = static_cast<size_t>(std::lower_bound(leaf->items, leaf->items + leaf->count, value) - leaf->items);
+            if (position < leaf->count && leaf->items[position] == value)
+            {
+                return false;
+            }
+
+            if (leaf->count < LeafCapacity)
+            {
+                std::copy_backward(leaf->items + position, leaf->items + leaf->count, leaf->items + leaf->count + 1);
+                leaf->items[position] = value;
+                ++leaf->count;
+                return true;
+            }
+
+            // Full leaf, lay out all the elements with the new one and split them in halves
+            T all[LeafCapacity + 1];
+            std::copy(leaf->items, leaf->items + position, all);
+            all[position] = value;
+            std::copy(leaf->items + position, leaf->items + leaf->count, all + position + 1);
+
+            Leaf *right = newLeaf();
+            size_t leftCount = (LeafCapacity + 1) / 2;
+            std::copy(all, all + leftCount, leaf->items);
+            std::copy(all + leftCount, all + LeafCapacity + 1, right->items);
+            leaf->count = leftCount;
+            right->count = LeafCapacity + 1 - leftCount;
+
+            right->previous = leaf;
+            right->next = leaf->next;
+            if (leaf->next != nullptr)
+            {
+                leaf->next->previous = right;
+            }
+            leaf->next = right;
+
+            split.right = right;
+            split.key = right->items[0];
+            return true;
+        }
+
+        // Inserts the right part of a split child at index, splitting the inner node itself when it's full
+        static void insertChild(Inner *inner, size_t index, const Split &childSplit, Split &split)
+        {
+            size_t childSize = sizeOf(childSplit.right);
+
+            if (inner->count < Fanout)
+            {
+                for (size_t i = inner->count; i > index; --i)
+                {
+                    inner->children[i] = inner->children[i - 1];
+                    inner->sizes[i] = inner->sizes[i - 1];
+                }
+                for (size_t i = inner->count - 1; i > index - 1; --i)
+                {
+                    inner->keys[i] = inner->keys[i - 1];
+                }
+
+                inner->children[index] = childSplit.right;
+                inner->sizes[index] = childSize;
+                inner->keys[index - 1] = childSplit.key;
+                ++inner->count;
+                return;
+            }
+
+            Node *children[Fanout + 1];
+            size_t sizes[Fanout + 1];
+            T keys[Fanout];
+            for (size_t i = 0, from = 0; i <= Fanout; ++i)
+            {
+                if (i == index)
+                {
+                    children[i] = childSplit.right;
+                    sizes[i] = childSize;
+                }
+                else
+                {
+                    children[i] = inner->children[from];
+                    sizes[i] = inner->sizes[from];
+                    ++from;
+                }
+            }
+            for (size_t i = 0, from = 0; i < Fanout; ++i)
+            {
+                keys[i] = (i == index - 1) ? childSplit.key : inner->keys[from++];
+            }
+
+            // The left half stays in inner, the key between the halves moves up to the parent
+            size_t leftCount = (Fanout + 1) / 2;
+            Inner *right = newInner();
+            right->count = Fanout + 1 - leftCount;
+            std::copy(children, children + leftCount, inner->children);
+            std::copy(sizes, sizes + leftCount, inner->sizes);
+            std::copy(keys, keys + leftCount - 1, inner->keys);
+            std::copy(children + leftCount, children + Fanout + 1, right->children);
+            std::copy(sizes + leftCount, sizes + Fanout + 1, right->sizes);
+            std::copy(keys + leftCount, keys + Fanout, right->keys);
+            inner->count = leftCount;
+
+            split.right = right;
+            split.key = keys[leftCount - 1];
+        }
+
+        // A node other than the root keeps at least half of its capacity, so scans don't cross near empty leaves
+        static size_t minimumCount(const Node *node)
+        {
+            return node->leaf ? LeafCapacity / 2 : Fanout / 2;
+        }
+
+        bool eraseFrom(Node *node, const T &value)
+        {
+            if (node->leaf)
+            {
+                Leaf *leaf = asLeaf(node);
+                size_t position = static_cast<size_t>(std::lower_bound(leaf->items, leaf->items + leaf->count, value) - leaf->items);
+                if (position == leaf->count || leaf->items[position] != value)
+                {
+                    return false;
+                }
+
+                std::copy(leaf->items + position + 1, leaf->items + leaf->count, leaf->items + position);
+                --leaf->count;
+                return true;
+            }
+
+            Inner *inner = asInner(node);
+            size_t child = childFor(inner, value);
+            if (!eraseFrom(inner->children[child], value))
+            {
+                return false;
+            }
+
+            --inner->sizes[child];
+            if (inner->children[child]->count < minimumCount(inner->children[child]))
+            {
+                rebalance(inner, child);
+            }
+            return true;
+        }
+
+        // Refills an underfull child from a sibling that can spare an entry, or merges the two when neither can.
+        // Merging fits, the child is below the minimum and the sibling at most at it
+        static void rebalance(Inner *inner, size_t child)
+        {
+            if (inner->count < 2)
+            {
+                return;
+            }
+
+            // The child and the sibling as a pair of neighbours, left being the index of the first of them
+            size_t left = (child > 0) ? child - 1 : child;
+            Node *sibling = inner->children[(left == child) ? left + 1 : left];
+            if (sibling->count <= minimumCount(sibling))
+            {
+                mergeChildren(inner, left);
+            }
+            else if (left == child)
+            {
+                moveToLeft(inner, left);
+            }
+            else
+            {
+                moveToRight(inner, left);
+            }
+        }
+
+        // Moves the last entry of children[left] to the front of children[left + 1]
+        static void moveToRight(Inner *inner, size_t left)
+        {
+            size_t moved = 1;
+            if (inner->children[left]->leaf)
+            {
+                Leaf *from = asLeaf(inner->children[left]);
+                Leaf *to = asLeaf(inner->children[left + 1]);
+                std::copy_backward(to->items, to->items + to->count, to->items + to->count + 1);
+                to->items[0] = from->items[from->count - 1];
+                --from->count;
+                ++to->count;
+                inner->keys[left] = to->items[0];
+            }
+            else
+            {
+                Inner *from = asInner(inner->children[left]);
+                Inner *to = asInner(inner->children[left + 1]);
+                std::copy_backward(to->children, to->children + to->count, to->children + to->count + 1);
+                std::copy_backward(to->sizes, to->sizes + to->count, to->sizes + to->count + 1);
+                std::copy_backward(to->keys, to->keys + to->count - 1, to->keys + to->count);
+                to->children[0] = from->children[from->count - 1];
+                to->sizes[0] = from->sizes[from->count - 1];
+                to->keys[0] = inner->keys[left];
+                inner->keys[left] = from->keys[from->count - 2];
+                moved = to->sizes[0];
+                --from->count;
+                ++to->count;
+            }
+            inner->sizes[left] -= moved;
+            inner->sizes[left + 1] += moved;
+        }
+
+        // Moves the first entry of children[left + 1] to the back of children[left]
+        static void moveToLeft(Inner *inner, size_t left)
+        {
+            size_t moved = 1;
+            if (inner->children[left]->leaf)
+            {
+                Leaf *to = asLeaf(inner->children[left]);
+                Leaf *from = asLeaf(inner->children[left + 1]);
+                to->items[to->count] = from->items[0];
+                std::copy(from->items + 1, from->items + from->count, from->items);
+                ++to->count;
+                --from->count;
+                inner->keys[left] = from->items[0];
+            }
+            else
+            {
+                Inner *to = asInner(inner->children[left]);
+                Inner *from = asInner(inner->children[left + 1]);
+                to->children[to->count] = from->children[0];
+                to->sizes[to->count] = from->sizes[0];
+                to->keys[to->count - 1] = inner->keys[left];
+                inner->keys[left] = from->keys[0];
+                moved = from->sizes[0];
+                std::copy(from->children + 1, from->children + from->count, from->children);
+                std::copy(from->sizes + 1, from->sizes + from->count, from->sizes);
+                std::copy(from->keys + 1, from->keys + from->count - 1, from->keys);
+                ++to->count;
+                --from->count;
+            }
+            inner->sizes[left] += moved;
+            inner->sizes[left + 1] -= moved;
+        }
+
+        // Moves everything of children[left + 1] into children[left] and frees it
+        static void mergeChildren(Inner *inner, size_t left)
+        {
+            if (inner->children[left]->leaf)
+            {
+                Leaf *to = asLeaf(inner->children[left]);
+                Leaf *from = asLeaf(inner->children[left + 1]);
+                std::copy(from->items, from->items + from->count, to->items + to->count);
+                to->count += from->count;
+                to->next = from->next;
+                if (from->next != nullptr)
+                {
+                    from->next->previous = to;
+                }
+                delete from;
+            }
+            else
+            {
+                Inner *to = asInner(inner->children[left]);
+                Inner *from = asInner(inner->children[left + 1]);
+                to->keys[to->count - 1] = inner->keys[left];
+                std::copy(from->keys, from->keys + from->count - 1, to->keys + to->count);
+                std::copy(from->children, from->children + from->count, to->children + to->count);
+                std::copy(from->sizes, from->sizes + from->count, to->sizes + to->count);
+                to->count += from->count;
+                delete from;
+            }
+
+            inner->sizes[left] += inner->sizes[left + 1];
+            for (size_t i = left + 1; i + 1 < inner->count; ++i)
+            {
+                inner->children[i] = inner->children[i + 1];
+                inner->sizes[i] = inner->sizes[i + 1];
+            }
+            for (size_t i = left; i + 2 < inner->count; ++i)
+            {
+                inner->keys[i] = inner->keys[i + 1];
+            }
+            --inner->count;
+        }
+
+        std::vector<T> toVector() const
+        {
+            std::vector<T> sorted;
+            sorted.reserve(total);
+            for (const Leaf *leaf = leftmostLeaf(); leaf != nullptr; leaf = leaf->next)
+            {
+                sorted.insert(sorted.end(), leaf->items, leaf->items + leaf->count);
+            }
+            return sorted;
+        }
+
+        // Builds the tree bottom up from sorted values in O(n), leaves are filled to about 3/4 to leave room for inserts.
+        // Every level is spread evenly over its nodes, so no node is left with a handful of entries at the end
+        void build(const std::vector<T> &sorted)
+        {
+            total = sorted.size();
+            if (sorted.empty())
+            {
+                root = newLeaf();
+                return;
+            }
+
+            struct Entry
+            {
+                Node *node;
+                size_t size;
+                T first;
+            };
+
+            std::vector<Entry> level;
+            size_t fill = LeafCapacity * 3 / 4;
+            size_t leafCount = (sorted.size() + fill - 1) / fill;
+            Leaf *previous = nullptr;
+            for (size_t index = 0; index < leafCount; ++index)
+            {
+                size_t start = sorted.size() * index / leafCount;
+                Leaf *leaf = newLeaf();
+                leaf->count = sorted.size() * (index + 1) / leafCount - start;
+                std::copy(sorted.begin() + static_cast<std::ptrdiff_t>(start), sorted.begin() + static_cast<std::ptrdiff_t>(start + leaf->count), leaf->items);
+                leaf->previous = previous;
+                if (previous != nullptr)
+                {
+                    previous->next = leaf;
+                }
+                previous = leaf;
+                level.push_back(Entry{leaf, leaf->count, leaf->items[0]});
+            }
+
+            while (level.size() > 1)
+            {
+                std::vector<Entry> parents;
+                size_t parentCount = (level.size() + Fanout - 1) / Fanout;
+                for (size_t index = 0; index < parentCount; ++index)
+                {
+                    size_t start = level.size() * index / parentCount;
+                    Inner *inner = newInner();
+                    inner->count = level.size() * (index + 1) / parentCount - start;
+                    size_t size = 0;
+                    for (size_t i = 0; i < inner->count; ++i)
+                    {
+                        inner->children[i] = level[start + i].node;
+                        inner->sizes[i] = level[start + i].size;
+                        if (i > 0)
+                        {
+                            inner->keys[i - 1] = level[start + i].first;
+                        }
+                        size += level[start + i].size;
+                    }
+                    parents.push_back(Entry{inner, size, level[start].first});
+                }
+                level.swap(parents);
+            }
+
+            root = level[0].node;
+        }
+
+    public:
+        BPlusTree() : root(newLeaf()), total(0) {}
+
+        BPlusTree(const BPlusTree &other) : root(nullptr), total(0)
+        {
+            build(other.toVector());
+        }
+
+        BPlusTree &operator=(const BPlusTree &other)
+        {
+            if (this != &other)
+            {
+                std::vector<T> sorted = other.toVector();
+                destroy(root);
+                build(sorted);
+            }
+            return *this;
+        }
+
+        ~BPlusTree()
+        {
+            destroy(root);
+        }
+
+        size_t size() const { return total; }
+        bool empty() const { return total == 0; }
+
+        const T &operator[](size_t rank) const
+        {
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                const Inner *inner = asInner(node);
+                size_t child = 0;
+                while (rank >= inner->sizes[child])
+                {
+                    rank -= inner->sizes[child];
+                    ++child;
+                }
+                node = inner->children[child];
+            }
+            return asLeaf(node)->items[rank];
+        }
+
+        const T &back() const
+        {
+            return (*this)[total - 1];
+        }
+
+        size_t lowerBound(const T &value) const
+        {
+            size_t rank = 0;
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                const Inner *inner = asInner(node);
+                size_t child = childFor(inner, value);
+                for (size_t i = 0; i < child; ++i)
+                {
+                    rank += inner->sizes[i];
+                }
+                node = inner->children[child];
+            }
+
+            const Leaf *leaf = asLeaf(node);
+            return rank + static_cast<size_t>(std::lower_bound(leaf->items, leaf->items + leaf->count, value) - leaf->items);
+        }
+
+        size_t upperBound(const T &value) const
+        {
+            size_t rank = 0;
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                const Inner *inner = asInner(node);
+                size_t child = childFor(inner, value);
+                for (size_t i = 0; i < child; ++i)
+                {
+                    rank += inner->sizes[i];
+                }
+                node = inner->children[child];
+            }
+
+            const Leaf *leaf = asLeaf(node);
+            return rank + static_cast<size_t>(std::upper_bound(leaf->items, leaf->items + leaf->count, value) - leaf->items);
+        }
+
+        bool contains(const T &value) const
+        {
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                const Inner *inner = asInner(node);
+                node = inner->children[childFor(inner, value)];
+            }
+
+            const Leaf *leaf = asLeaf(node);
+            return std::binary_search(leaf->items, leaf->items + leaf->count, value);
+        }
+
+        // Returns false, and changes nothing, if the value is already stored
+        bool insert(const T &value)
+        {
+            Split split;
+            if (!insertInto(root, value, split))
+            {
+                return false;
+            }
+
+            if (split.right != nullptr)
+            {
+                Inner *newRoot = newInner();
+                newRoot->count = 2;
+                newRoot->children[0] = root;
+                newRoot->children[1] = split.right;
+                newRoot->sizes[0] = sizeOf(root);
+                newRoot->sizes[1] = sizeOf(split.right);
+                newRoot->keys[0] = split.key;
+                root = newRoot;
+            }
+
+            ++total;
+            return true;
+        }
+
+        // Returns false if the value isn't stored
+        bool erase(const T &value)
+        {
+            if (!eraseFrom(root, value))
+            {
+                return false;
+            }
+            --total;
+
+            // Merging children can leave the root with a single one, which then becomes the root
+            while (!root->leaf && asInner(root)->count == 1)
+            {
+                Inner *oldRoot = asInner(root);
+                root = oldRoot->children[0];
+                delete oldRoot;
+            }
+            return true;
+        }
+
+        // Adds sorted values that aren't stored yet, rebuilding the tree in one linear pass
+        void merge(const std::vector<T> &additions)
+        {
+            std::vector<T> current = toVector();
+            std::vector<T> merged(current.size() + additions.size());
+            std::merge(current.begin(), current.end(), additions.begin(), additions.end(), merged.begin());
+            destroy(root);
+            build(merged);
+        }
+
+        // Removes sorted values in one linear pass, values that aren't stored are ignored
+        void eraseAll(const std::vector<T> &removals)
+        {
+            std::vector<T> kept;
+            kept.reserve(total);
+            auto removed = removals.begin();
+            for (const Leaf *leaf = leftmostLeaf(); leaf != nullptr; leaf = leaf->next)
+            {
+                for (size_t i = 0; i < leaf->count; ++i)
+                {
+                    while (removed != removals.end() && *removed < leaf->items[i])
+                    {
+                        ++removed;
+                    }
+
+                    if (removed == removals.end() || *removed != leaf->items[i])
+                    {
+                        kept.push_back(leaf->items[i]);
+                    }
+                }
+            }
+            destroy(root);
+            build(kept);
+        }
+
+        // The leaf holding rank. The neighbours of the hint are tried first, so scans only follow leaf links
+        Block blockFor(size_t rank, const Block &hint) const
+        {
+            const Leaf *leaf = static_cast<const Leaf *>(hint.node);
+            if (leaf != nullptr)
+            {
+                if (leaf->next != nullptr && rank - (hint.start + leaf->count) < leaf->next->count)
+                {
+                    return Block{leaf->next, hint.start + leaf->count, std::span<const T>(leaf->next->items, leaf->next->count)};
+                }
+
+                if (leaf->previous != nullptr && rank - (hint.start - leaf->previous->count) < leaf->previous->count)
+                {
+                    return Block{leaf->previous, hint.start - leaf->previous->count, std::span<const T>(leaf->previous->items, leaf->previous->count)};
+                }
+            }
+
+            size_t start = rank;
+            const Node *node = root;
+            while (!node->leaf)
+            {
+                const Inner *inner = asInner(node);
+                size_t child = 0;
+                while (child + 1 < inner->count && rank >= inner->sizes[child])
+                {
+                    rank -= inner->sizes[child];
+                    ++child;
+                }
+                node = inner->children[child];
+            }
+
+            leaf = asLeaf(node);
+            return Block{leaf, start - rank, std::span<const T>(leaf->items, leaf->count)};
+        }
+    };
+}
+
+#endif
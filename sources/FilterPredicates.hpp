@@ -0,0 +1,65 @@
+#ifndef FILTER_PREDICATES_HPP
+#define FILTER_PREDICATES_HPP
+#include <cmath>
+#include <cstdint>
+
+// Ready made predicates for BasicMagicalContainer::FilterIterator
+namespace ariel
+{
+    // Cheap enough to test while scanning, so no index is kept
+    struct IsEven
+    {
+        template <typename T>
+        bool operator()(const T &value) const
+        {
+            return value % 2 == 0;
+        }
+    };
+
+    // Squares are sparse, an index saves scanning past everything else
+    struct IsPerfectSquare
+    {
+        static constexpr bool indexed = true;
+
+        template <typename T>
+        bool operator()(const T &value) const
+        {
+            if (value < 0)
+            {
+                return false;
+            }
+
+            // The floating point root can be one off for big values
+            uint64_t number = static_cast<uint64_t>(value);
+            uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(number)));
+            while (root > 0 && root * root > number)
+            {
+                --root;
+            }
+            while ((root + 1) * (root + 1) <= number)
+            {
+                ++root;
+            }
+            return root * root == number;
+        }
+    };
+
+    // The values v in 0..63 whose bit v is set in Mask
+    template <uint64_t Mask>
+    struct InBitmask
+    {
+        static constexpr bool indexed = true;
+
+        template <typename T>
+        bool operator()(const T &value) const
+        {
+            if (value < 0 || value >= 64)
+            {
+                return false;
+            }
+            return ((Mask >> static_cast<unsigned>(value)) & 1) != 0;
+        }
+    };
+}
+
+#endif
@@ -1,95 +1,706 @@
 #ifndef MAGICAL_CONTAINER_HPP
 #define MAGICAL_CONTAINER_HPP
+#include "BPlusTree.hpp"
+#include "Primality.hpp"
+#include "ReadMostlyLock.hpp"
+#include "SortedVector.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
 #include <vector>
 using namespace std;
 
 namespace ariel
 {
-    class MagicalContainer
+    // Converts a cross order position to an index in the sorted elements and back
+    size_t crossToSorted(size_t crossPosition, size_t size);
+    size_t sortedToCross(size_t sortedIndex, size_t size);
+
+    // How a container is shared between threads, chosen when it is constructed
+    enum class Threading : unsigned char
+    {
+        SingleThread, // Nothing is locked, the container and its iterators are used by one thread at a time
+        Shared        // Any number of threads read at once, writes wait for the readers and run one at a time
+    };
+
+    // A part of a traversal returned by split, its size is known without walking it
+    template <typename Walker>
+    class IteratorRange
     {
+        Walker first;
+        Walker last;
+        size_t count;
+
+    public:
+        IteratorRange(const Walker &first, const Walker &last, size_t count) : first(first), last(last), count(count) {}
+
+        Walker begin() const { return first; }
+        Walker end() const { return last; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+    };
+
+    // T is the integral type of the elements, narrow types keep more of them in every cache line.
+    // Storage is the layout of the elements and of the prime index, chosen at compile time.
+    // SortedVector scans fastest, BPlusTree inserts and removes in O(log n) on big containers.
+    // A storage of your own needs the interface of SortedVector, see MagicalContainerImpl.hpp.
+    template <typename T = int, template <typename> class Storage = SortedVector>
+    class BasicMagicalContainer
+    {
+        static_assert(std::is_integral_v<T>, "The elements of a MagicalContainer are integers");
+
+        using ElementStorage = Storage<T>;
+
         class Iterator
         {
         public:
-            vector<int> sortedVec;
-            MagicalContainer *original_container;
-            int* currentElement;
-            bool endOfIteration;
-
-            Iterator() : currentElement(nullptr), original_container(nullptr), sortedVec(), endOfIteration(false) {} // Initialize currentElement to nullptr
-            Iterator(MagicalContainer* original_container);
-            Iterator(MagicalContainer* original_container, int index);
-            vector<int> getSortedVec() const;
+            // The order of traversal of the iterator, checked instead of run-time type information
+            enum class Kind : unsigned char
+            {
+                Ascending,
+                SideCross,
+                Prime,
+                Filter
+            };
+
+            // What the iterator remembers about its element to find it again after the container changed
+            enum class Anchor : unsigned char
+            {
+                None,  // The container was empty
+                At,    // anchor is the element the iterator points on
+                After  // The iterator is past the end and anchor is the last element it passed
+            };
+
+            // Elements are read only, and dereferencing returns a copy: the elements are integers, and a reference
+            // into the storage of a shared container could be moved or freed by a writer on another thread
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using reference = T;
+
+            BasicMagicalContainer *original_container;
+            mutable size_t position; // Position of the iterator in its own order of traversal
+            Kind kind;
+            unsigned char shard; // The shard of the container's registry the iterator is linked in
+            Iterator *previousLive; // Neighbours in the container's list of live iterators
+            Iterator *nextLive;
+            mutable unsigned long generation; // Container generation the position is valid for
+            mutable T anchor;
+            mutable Anchor anchorMode;
+            // The element the iterator was on was removed and the position already moved on to its successor,
+            // so the next step forward stays there instead of skipping it, unless the successor was read since.
+            // SideCross positions don't follow it
+            mutable bool onSuccessor;
+            mutable typename ElementStorage::Block blocks[2]; // Last blocks read, SideCross keeps one for each end
+            bool (*accepts)(const T &); // The predicate of a FilterIterator, nullptr for the other kinds
+            const ElementStorage *filtered; // The index of an indexed predicate, nullptr when the elements are scanned
+
+            explicit Iterator(Kind kind) : original_container(nullptr), position(0), kind(kind), shard(0), previousLive(nullptr), nextLive(nullptr), generation(0), anchor(0), anchorMode(Anchor::None), onSuccessor(false), accepts(nullptr), filtered(nullptr) {}
+            Iterator(Kind kind, BasicMagicalContainer *original_container);
+            Iterator(Kind kind, BasicMagicalContainer *original_container, int index);
+            Iterator(Kind kind, BasicMagicalContainer *original_container, int index, bool (*accepts)(const T &), const ElementStorage *filtered);
+
+            // Marks the iterator built past the last element. The end is found under the lock that places the
+            // iterator, a size read before could be stale by then in a shared container
+            struct AtEnd
+            {
+            };
+            Iterator(Kind kind, BasicMagicalContainer *original_container, AtEnd end, bool (*accepts)(const T &), const ElementStorage *filtered);
             Iterator(const Iterator& other);
             Iterator& operator=(const Iterator& other);
 
-            virtual ~Iterator() = default;
+            ~Iterator();
+
+        private:
+            Iterator(Kind kind, BasicMagicalContainer *original_container, size_t position, bool atEnd, bool (*accepts)(const T &), const ElementStorage *filtered);
+
+        public:
+
+            // Registration in the container's registry of live iterators, both O(1).
+            // An iterator links into the shard of its thread, so copies don't contend across threads
+            void link();
+            void unlink();
+
+            // Remembers the current element and the container generation, and finds the element again
+            // with a binary search once the container changed, so writes never have to visit iterators
+            void capture() const;
+            void reanchor() const;
+            // Holds writers off while the iterator reads a shared container. Every public operation that reads
+            // takes it once, the helpers below it don't, so a thread never locks the same container twice
+            std::shared_lock<ReadMostlyLock> readLock() const
+            {
+                if (original_container == nullptr)
+                {
+                    return std::shared_lock<ReadMostlyLock>();
+                }
+                return original_container->readLock();
+            }
+
+            void sync() const
+            {
+                if (original_container != nullptr && generation != original_container->generation)
+                {
+                    reanchor();
+                }
+            }
+
+            // Moves a scanning FilterIterator forward to the first element its predicate accepts
+            void settle() const;
+
+            // The position ++ moves to, the same one when the iterator already stands on the successor of its removed element
+            size_t nextPosition() const
+            {
+                if (original_container == nullptr || (position >= traversed().size() && !onSuccessor))
+                {
+                    throw std::runtime_error("Iterator has reached the end");
+                }
+                return onSuccessor ? position : position + 1;
+            }
+
+            // The sorted sequence the position is an index into: the primes, a filter's index or all the elements
+            const ElementStorage &traversed() const
+            {
+                if (kind == Kind::Prime)
+                {
+                    return original_container->primes;
+                }
+                return (filtered != nullptr) ? *filtered : original_container->elements;
+            }
+
+            // Random access over a sorted sequence of size elements, the position may end anywhere in [0, size].
+            // O(1) over the flat vector and O(log n) over the B+ tree
+            size_t offsetPosition(std::ptrdiff_t offset, size_t size) const;
+            void moveBy(std::ptrdiff_t offset, size_t size);
+            const T &readAt(const ElementStorage &sequence, std::ptrdiff_t offset) const;
+
+            // Every iterator kind has nextBatch(out): it copies up to out.size() elements in its own order, moves
+            // past them and returns how many, 0 at the end instead of throwing. This is its copy for the kinds
+            // that walk a sorted sequence, a whole block at a time
+            size_t copyRun(const ElementStorage &sequence, std::span<T> out);
+
+            // Behind split(parts) of every iterator kind, the ranges parallelForEach hands out to its threads.
+            // Cuts the rest of the traversal into parts consecutive ranges whose sizes differ by at most one.
+            // Only positions are computed, each range costs the construction of its two iterators
+            template <typename Walker>
+            vector<IteratorRange<Walker>> splitInto(size_t parts) const
+            {
+                if (original_container == nullptr)
+                {
+                    throw std::runtime_error("Can't split an iterator without a container");
+                }
 
-            int &operator*();
-            Iterator &operator++();
+                if (parts == 0)
+                {
+                    throw invalid_argument("Can't split into 0 parts");
+                }
 
-            bool operator==(const Iterator &other) const;
-            bool operator!=(const Iterator &other) const;
-            bool operator<(const Iterator &other) const;
-            bool operator>(const Iterator &other) const;
+                // The lock is released before the iterators of the ranges lock the container themselves
+                size_t total = 0;
+                {
+                    auto lock = readLock();
+                    sync();
+                    total = traversed().size() - position;
+                }
+                vector<IteratorRange<Walker>> ranges;
+                ranges.reserve(parts);
+                size_t first = position;
+                for (size_t part = 1; part <= parts; ++part)
+                {
+                    size_t last = position + total / parts * part + total % parts * part / parts;
+                    ranges.emplace_back(Walker(*original_container, static_cast<int>(first)), Walker(*original_container, static_cast<int>(last)), last - first);
+                    first = last;
+                }
+                return ranges;
+            }
+
+            // Reads through the block cached in slot, the storage is only searched when the scan leaves the block
+            const T &cachedRead(const ElementStorage &sequence, size_t index, size_t slot) const
+            {
+                typename ElementStorage::Block &block = blocks[slot];
+                if (!block.holds(index))
+                {
+                    block = sequence.blockFor(index, block);
+                }
+                return block.items[index - block.start];
+            }
+
+            // Comparisons are only valid between iterators of the same order over the same container
+            size_t comparablePosition(const Iterator &other) const
+            {
+                if (original_container != other.original_container)
+                {
+                    throw std::runtime_error("Can't compare Iterators with different MagicalContainers");
+                }
+
+                if (kind != other.kind || accepts != other.accepts)
+                {
+                    throw std::runtime_error("The iterators are of different types");
+                }
+
+                auto lock = readLock();
+                sync();
+                other.sync();
+                return position;
+            }
+
+            // All comparisons are on the position of the iterators and not on the elements
+            bool operator==(const Iterator &other) const { return comparablePosition(other) == other.position; }
+            bool operator!=(const Iterator &other) const { return comparablePosition(other) != other.position; }
+            bool operator<(const Iterator &other) const { return comparablePosition(other) < other.position; }
+            bool operator>(const Iterator &other) const { return comparablePosition(other) > other.position; }
+            bool operator<=(const Iterator &other) const { return comparablePosition(other) <= other.position; }
+            bool operator>=(const Iterator &other) const { return comparablePosition(other) >= other.position; }
+        };
+
+        // The random access operators of the kinds that walk their sorted sequence by rank, the ascending elements
+        // and the primes. Walker is the iterator kind, it picks its sequence through traversed()
+        template <typename Walker>
+        class RankedAccess
+        {
+        public:
+            Walker &operator--()
+            {
+                return walker() -= 1;
+            }
+
+            Walker operator--(int)
+            {
+                Walker previous(walker());
+                --walker();
+                return previous;
+            }
+
+            Walker &operator+=(std::ptrdiff_t offset)
+            {
+                Walker &self = walker();
+                auto lock = self.readLock();
+                self.moveBy(offset, (self.original_container == nullptr) ? 0 : self.traversed().size());
+                return self;
+            }
+
+            Walker &operator-=(std::ptrdiff_t offset)
+            {
+                // -offset would overflow for the smallest ptrdiff_t
+                if (offset == PTRDIFF_MIN)
+                {
+                    throw std::runtime_error("Iterator moved out of the container");
+                }
+                return walker() += -offset;
+            }
+
+            Walker operator+(std::ptrdiff_t offset) const
+            {
+                Walker moved(walker());
+                moved += offset;
+                return moved;
+            }
+
+            Walker operator-(std::ptrdiff_t offset) const
+            {
+                Walker moved(walker());
+                moved -= offset;
+                return moved;
+            }
+
+            std::ptrdiff_t operator-(const Walker &other) const
+            {
+                return static_cast<std::ptrdiff_t>(walker().comparablePosition(other)) - static_cast<std::ptrdiff_t>(other.position);
+            }
+
+            T operator[](std::ptrdiff_t offset) const
+            {
+                const Walker &self = walker();
+                auto lock = self.readLock();
+                if (self.original_container == nullptr)
+                {
+                    throw std::runtime_error("Iterator is not pointing to a valid element");
+                }
+                return self.readAt(self.traversed(), offset);
+            }
+
+            friend Walker operator+(std::ptrdiff_t offset, const Walker &iterator)
+            {
+                return iterator + offset;
+            }
+
+        private:
+            Walker &walker() { return static_cast<Walker &>(*this); }
+            const Walker &walker() const { return static_cast<const Walker &>(*this); }
+        };
+
+        ElementStorage elements;
+        ElementStorage primes; // The prime elements, kept sorted alongside elements
+        unsigned long generation; // Bumped by every change of the elements
+        Threading threading;
+        mutable std::unique_ptr<ReadMostlyLock> access; // Shared by the readers of a shared container, owned by its writers
+
+        // Intrusive lists of the live iterators over this container, a single one unless the container is shared
+        struct alignas(64) RegistryShard
+        {
+            std::mutex lock; // Iterators come and go on any thread, but mostly on the one that made them
+            Iterator *head = nullptr;
+        };
+        std::unique_ptr<RegistryShard[]> registry;
+        size_t registryShards;
+
+        // The elements an indexed FilterIterator predicate accepts, kept sorted alongside elements like the primes
+        struct FilterIndex
+        {
+            bool (*accepts)(const T &);
+            std::unique_ptr<ElementStorage> values; // Iterators point at it, so it must not move
         };
+        std::vector<FilterIndex> filterIndexes;
 
-        std::vector<int> elements;
-        std::vector<Iterator*> iterators; // Collection of iterators
+        void mergeBatch(vector<T> batch);
+        static vector<T> acceptedElements(const vector<T> &batch, bool (*accepts)(const T &));
+        void removeBatch(vector<T> batch);
+
+        // Finds the index of a predicate, and builds it on first use
+        const ElementStorage &filterIndex(bool (*accepts)(const T &));
+        const ElementStorage *findFilterIndex(bool (*accepts)(const T &)) const;
+        vector<T> matchingElements(bool (*accepts)(const T &)) const;
+
+        // The locks of a shared container, none of them locks anything for a single thread one
+        std::shared_lock<ReadMostlyLock> readLock() const
+        {
+            return (threading == Threading::Shared) ? std::shared_lock<ReadMostlyLock>(*access) : std::shared_lock<ReadMostlyLock>();
+        }
+
+        std::unique_lock<ReadMostlyLock> writeLock()
+        {
+            return (threading == Threading::Shared) ? std::unique_lock<ReadMostlyLock>(*access) : std::unique_lock<ReadMostlyLock>();
+        }
+
+        std::unique_lock<std::mutex> registryLock(size_t shard)
+        {
+            return (threading == Threading::Shared) ? std::unique_lock<std::mutex>(registry[shard].lock) : std::unique_lock<std::mutex>();
+        }
 
     public:
-        MagicalContainer();
-        ~MagicalContainer() = default;
+        BasicMagicalContainer();
+
+        // A Shared container can be read from several threads at once, each thread with iterators of its own.
+        // Readers don't wait for each other, and reading in batches with nextBatch takes the lock once per batch
+        explicit BasicMagicalContainer(Threading threading);
+        BasicMagicalContainer(const BasicMagicalContainer &other);
+        BasicMagicalContainer &operator=(const BasicMagicalContainer &other);
+        ~BasicMagicalContainer();
+
+        void addElement(T element);
+
+        // Adds a batch of elements with one sort and one merge pass, nothing is added if any of them is a duplicate
+        void addElements(std::span<const T> elements_to_add);
+        template <typename InputIt>
+        void addElements(InputIt first, InputIt last)
+        {
+            mergeBatch(vector<T>(first, last));
+        }
+
+        void removeElement(T element);
+
+        // Removes a batch of elements in one compaction pass, nothing is removed if any of them is missing
+        void removeElements(std::span<const T> elements_to_remove);
+        template <typename InputIt>
+        void removeElements(InputIt first, InputIt last)
+        {
+            removeBatch(vector<T>(first, last));
+        }
 
-        void addElement(int element);
-        void removeElement(int element);
         int size() const;
 
-        class AscendingIterator : public Iterator
+        // The prime index is kept alongside the elements, so counting the primes is O(1)
+        int primeCount() const;
+
+        // Random access by rank among the elements
+        class AscendingIterator : public Iterator, public RankedAccess<AscendingIterator>
         {
         public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::random_access_iterator_tag; // Returns copies like vector<bool>::iterator, the legacy algorithms still jump
+
             AscendingIterator();
-            AscendingIterator(MagicalContainer &container);
-            AscendingIterator(MagicalContainer &container, int index);
+            AscendingIterator(BasicMagicalContainer &container);
+            AscendingIterator(BasicMagicalContainer &container, int index);
+            AscendingIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end);
             AscendingIterator(const AscendingIterator &other);
-            ~AscendingIterator() override = default;
+            ~AscendingIterator() = default;
 
             AscendingIterator &operator=(const AscendingIterator &other);
 
+            // Reads straight from the container, no private copy is kept
+            T operator*() const;
+            AscendingIterator &operator++();
+            AscendingIterator operator++(int);
+
+            size_t nextBatch(std::span<T> out);
+            vector<IteratorRange<AscendingIterator>> split(size_t parts) const;
+
             AscendingIterator begin();
             AscendingIterator end();
+
+            // Descending order, without walking the elements before the ones it returns
+            std::reverse_iterator<AscendingIterator> rbegin();
+            std::reverse_iterator<AscendingIterator> rend();
         };
 
         class SideCrossIterator : public Iterator
         {
         public:
+            using iterator_concept = std::bidirectional_iterator_tag;
+            using iterator_category = std::bidirectional_iterator_tag;
+
             SideCrossIterator();
-            SideCrossIterator(MagicalContainer &container);
-            SideCrossIterator(MagicalContainer &container, int index);
+            SideCrossIterator(BasicMagicalContainer &container);
+            SideCrossIterator(BasicMagicalContainer &container, int index);
+            SideCrossIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end);
             SideCrossIterator(const SideCrossIterator &other);
-            ~SideCrossIterator() override = default;
+            ~SideCrossIterator() = default;
 
             SideCrossIterator &operator=(const SideCrossIterator &other);
 
+            // Cross position k maps to elements[k/2] for even k and to elements[size-1-k/2] for odd k
+            T operator*() const;
+            SideCrossIterator &operator++();
+            SideCrossIterator operator++(int);
+            SideCrossIterator &operator--();
+            SideCrossIterator operator--(int);
+
+            size_t nextBatch(std::span<T> out);
+
+            // Every range is a run of consecutive cross positions, so it keeps the global cross order
+            vector<IteratorRange<SideCrossIterator>> split(size_t parts) const;
+
             SideCrossIterator begin();
             SideCrossIterator end();
+
+            // The cross order from its middle back out to the smallest element
+            std::reverse_iterator<SideCrossIterator> rbegin();
+            std::reverse_iterator<SideCrossIterator> rend();
         };
 
-        class PrimeIterator : public Iterator
+        // Random access by rank among the primes
+        class PrimeIterator : public Iterator, public RankedAccess<PrimeIterator>
         {
         public:
+            using iterator_concept = std::random_access_iterator_tag;
+            using iterator_category = std::random_access_iterator_tag;
+
             PrimeIterator();
-            PrimeIterator(MagicalContainer &container);
-            PrimeIterator(MagicalContainer &container, int index);
+            PrimeIterator(BasicMagicalContainer &container);
+            PrimeIterator(BasicMagicalContainer &container, int index);
+            PrimeIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end);
             PrimeIterator(const PrimeIterator &other);
-            ~PrimeIterator() override = default;
+            ~PrimeIterator() = default;
 
             PrimeIterator &operator=(const PrimeIterator &other);
 
+            // Walks the container's prime index, no element is tested here
+            T operator*() const;
+            PrimeIterator &operator++();
+            PrimeIterator operator++(int);
+
+            size_t nextBatch(std::span<T> out);
+            vector<IteratorRange<PrimeIterator>> split(size_t parts) const;
+
             PrimeIterator begin();
             PrimeIterator end();
+
+            // The primes from the biggest down
+            std::reverse_iterator<PrimeIterator> rbegin();
+            std::reverse_iterator<PrimeIterator> rend();
+        };
+
+        // Walks the elements Predicate accepts in ascending order, Predicate is a default constructible
+        // function object and is called inline. A predicate that declares static constexpr bool indexed = true
+        // gets an index the container keeps up to date like the primes, so the iterator never tests an element.
+        // Any other predicate is tested while the iterator scans the elements
+        template <typename Predicate>
+        class FilterIterator : public Iterator
+        {
+            static constexpr bool Indexed = requires { requires Predicate::indexed; };
+
+            static bool test(const T &value)
+            {
+                return Predicate{}(value);
+            }
+
+        public:
+            using iterator_concept = std::bidirectional_iterator_tag;
+            using iterator_category = std::bidirectional_iterator_tag;
+
+            FilterIterator() : Iterator(Iterator::Kind::Filter)
+            {
+                this->accepts = &test;
+            }
+
+            FilterIterator(BasicMagicalContainer &container) : FilterIterator(container, 0) {}
+
+            FilterIterator(BasicMagicalContainer &container, int index)
+                : Iterator(Iterator::Kind::Filter, &container, index, &test, Indexed ? &container.filterIndex(&test) : nullptr)
+            {}
+
+            FilterIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end)
+                : Iterator(Iterator::Kind::Filter, &container, end, &test, Indexed ? &container.filterIndex(&test) : nullptr)
+            {}
+
+            FilterIterator(const FilterIterator &other) : Iterator(other) {}
+            ~FilterIterator() = default;
+
+            FilterIterator &operator=(const FilterIterator &other)
+            {
+                Iterator::operator=(other);
+                return *this;
+            }
+
+            T operator*() const
+            {
+                auto lock = this->readLock();
+                this->sync();
+                if (this->original_container == nullptr || this->position >= this->traversed().size())
+                {
+                    throw std::runtime_error("Iterator is not pointing to a valid element");
+                }
+
+                this->onSuccessor = false;
+                return this->cachedRead(this->traversed(), this->position, 0);
+            }
+
+            FilterIterator &operator++()
+            {
+                auto lock = this->readLock();
+                this->sync();
+                this->position = this->nextPosition();
+                if constexpr (!Indexed)
+                {
+                    const ElementStorage &elements = this->original_container->elements;
+                    while (this->position < elements.size() && !test(this->cachedRead(elements, this->position, 0)))
+                    {
+                        ++this->position;
+                    }
+                }
+
+                this->capture();
+                return *this;
+            }
+
+            FilterIterator operator++(int)
+            {
+                FilterIterator previous(*this);
+                ++*this;
+                return previous;
+            }
+
+            FilterIterator &operator--()
+            {
+                auto lock = this->readLock();
+                this->sync();
+                if (this->original_container == nullptr)
+                {
+                    throw std::runtime_error("Iterator has reached the beginning");
+                }
+
+                // Nothing moves unless an accepted element comes before the iterator
+                size_t previous = this->position;
+                do
+                {
+                    if (previous == 0)
+                    {
+                        throw std::runtime_error("Iterator has reached the beginning");
+                    }
+                    --previous;
+                } while (!Indexed && !test(this->cachedRead(this->original_container->elements, previous, 0)));
+
+                this->position = previous;
+                this->capture();
+                return *this;
+            }
+
+            FilterIterator operator--(int)
+            {
+                FilterIterator previous(*this);
+                --*this;
+                return previous;
+            }
+
+            size_t nextBatch(std::span<T> out)
+            {
+                auto lock = this->readLock();
+                this->sync();
+                if (this->original_container == nullptr)
+                {
+                    return 0;
+                }
+
+                if constexpr (Indexed)
+                {
+                    return this->copyRun(*this->filtered, out);
+                }
+                else
+                {
+                    // Tests a block at a time and stops on the first accepted element that doesn't fit
+                    const ElementStorage &elements = this->original_container->elements;
+                    size_t copied = 0;
+                    while (copied < out.size() && this->position < elements.size())
+                    {
+                        const T &element = this->cachedRead(elements, this->position, 0);
+                        if (test(element))
+                        {
+                            out[copied++] = element;
+                        }
+                        ++this->position;
+                    }
+
+                    this->settle();
+                    this->capture();
+                    return copied;
+                }
+            }
+
+            // Only indexed predicates can be split, a scanning one doesn't know how many elements it has left
+            vector<IteratorRange<FilterIterator>> split(size_t parts) const
+                requires Indexed
+            {
+                return this->template splitInto<FilterIterator>(parts);
+            }
+
+            FilterIterator begin()
+            {
+                return FilterIterator(*this->original_container, 0);
+            }
+
+            FilterIterator end()
+            {
+                return FilterIterator(*this->original_container, typename Iterator::AtEnd{});
+            }
+
+            std::reverse_iterator<FilterIterator> rbegin()
+            {
+                return std::reverse_iterator<FilterIterator>(end());
+            }
+
+            std::reverse_iterator<FilterIterator> rend()
+            {
+                return std::reverse_iterator<FilterIterator>(begin());
+            }
         };
     };
+
+    using MagicalContainer = BasicMagicalContainer<>;
+
+    // Instantiated once in MagicalContainer.cpp
+    extern template class BasicMagicalContainer<int, SortedVector>;
+    extern template class BasicMagicalContainer<int, BPlusTree>;
+    extern template class BasicMagicalContainer<int16_t, SortedVector>;
+    extern template class BasicMagicalContainer<int16_t, BPlusTree>;
+    extern template class BasicMagicalContainer<uint32_t, SortedVector>;
+    extern template class BasicMagicalContainer<uint32_t, BPlusTree>;
+    extern template class BasicMagicalContainer<int64_t, SortedVector>;
+    extern template class BasicMagicalContainer<int64_t, BPlusTree>;
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,1031 @@
+#ifndef MAGICAL_CONTAINER_IMPL_HPP
+#define MAGICAL_CONTAINER_IMPL_HPP
+#include "MagicalContainer.hpp"
+#include "PrimeClassifier.hpp"
+#include <algorithm>
+
+// Member definitions of BasicMagicalContainer. MagicalContainer.cpp instantiates them for the storages
+// of the library, include this header to use the container over a storage of your own.
+namespace ariel
+{
+    // ===============MagicalContainer=================
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::BasicMagicalContainer() : BasicMagicalContainer(Threading::SingleThread)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::BasicMagicalContainer(Threading threading)
+        : generation(0), threading(threading), registryShards((threading == Threading::Shared) ? ReadMostlyLock::Slots : 1)
+    {
+        // A single thread container locks nothing, so it doesn't pay for the lock slots either
+        if (threading == Threading::Shared)
+        {
+            access = std::make_unique<ReadMostlyLock>();
+        }
+        registry = std::make_unique<RegistryShard[]>(registryShards);
+    }
+
+    // A copy gets the elements, the filter indexes and the threading of the original but none of its iterators
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::BasicMagicalContainer(const BasicMagicalContainer &other)
+        : BasicMagicalContainer(other.threading)
+    {
+        auto lock = other.readLock();
+        elements = other.elements;
+        primes = other.primes;
+        for (const FilterIndex &index : other.filterIndexes)
+        {
+            filterIndexes.push_back(FilterIndex{index.accepts, std::make_unique<ElementStorage>(*index.values)});
+        }
+    }
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage> &BasicMagicalContainer<T, Storage>::operator=(const BasicMagicalContainer &other)
+    {
+        if (this != &other)
+        {
+            // Copying first means the two containers are never locked together
+            BasicMagicalContainer copy(other);
+            auto lock = writeLock();
+            elements = std::move(copy.elements);
+            primes = std::move(copy.primes);
+
+            // Iterators keep pointing at the indexes, so they are refilled in place
+            for (FilterIndex &index : filterIndexes)
+            {
+                *index.values = ElementStorage();
+                index.values->merge(matchingElements(index.accepts));
+            }
+            ++generation;
+        }
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::~BasicMagicalContainer()
+    {
+        // Detach the iterators that outlive the container so they don't touch freed memory
+        for (size_t shard = 0; shard < registryShards; ++shard)
+        {
+            auto lock = registryLock(shard);
+            Iterator *iterator = registry[shard].head;
+            while (iterator != nullptr)
+            {
+                Iterator *next = iterator->nextLive;
+                iterator->original_container = nullptr;
+                iterator->previousLive = nullptr;
+                iterator->nextLive = nullptr;
+                iterator = next;
+            }
+        }
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::addElement(T element_to_add)
+    {
+        // Classified before the lock is taken like a batch, the prime test of a big element may have to sieve
+        bool prime = isPrime(element_to_add);
+        vector<bool> accepted;
+        {
+            auto lock = readLock();
+            for (const FilterIndex &index : filterIndexes)
+            {
+                accepted.push_back(index.accepts(element_to_add));
+            }
+        }
+
+        auto lock = writeLock();
+        if (!elements.insert(element_to_add))
+        {
+            throw invalid_argument("Can't add a duplicate element");
+        }
+
+        // Keep the prime index up to date, iterators read it directly
+        if (prime)
+        {
+            primes.insert(element_to_add);
+        }
+
+        // Indexes are never dropped, but one may have been built between the two locks
+        for (size_t i = 0; i < filterIndexes.size(); ++i)
+        {
+            if (i == accepted.size())
+            {
+                accepted.push_back(filterIndexes[i].accepts(element_to_add));
+            }
+            if (accepted[i])
+            {
+                filterIndexes[i].values->insert(element_to_add);
+            }
+        }
+
+        // Live iterators find their element again on their next access
+        ++generation;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::addElements(std::span<const T> elements_to_add)
+    {
+        mergeBatch(vector<T>(elements_to_add.begin(), elements_to_add.end()));
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::mergeBatch(vector<T> batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+
+        // Sorted, checked and classified before the lock is taken, readers only wait for the merge itself
+        sort(batch.begin(), batch.end());
+        if (adjacent_find(batch.begin(), batch.end()) != batch.end())
+        {
+            throw invalid_argument("Can't add a duplicate element");
+        }
+
+        // Classify the whole batch at once, the vector pre-filter settles most composites
+        PrimeBits primeBits;
+        classifyPrimes(std::span<const T>(batch), primeBits);
+
+        vector<T> batchPrimes;
+        for (size_t i = 0; i < batch.size(); ++i)
+        {
+            if (testPrimeBit(primeBits, i))
+            {
+                batchPrimes.push_back(batch[i]);
+            }
+        }
+
+        // The predicates only need the indexes to exist, which other readers don't mind
+        vector<vector<T>> accepted;
+        {
+            auto lock = readLock();
+            for (const FilterIndex &index : filterIndexes)
+            {
+                accepted.push_back(acceptedElements(batch, index.accepts));
+            }
+        }
+
+        auto lock = writeLock();
+
+        // Reject duplicates before touching the container
+        for (T element_to_add : batch)
+        {
+            if (elements.contains(element_to_add))
+            {
+                throw invalid_argument("Can't add a duplicate element");
+            }
+        }
+
+        // Indexes are never dropped, but one may have been built between the two locks
+        for (size_t i = 0; i < filterIndexes.size(); ++i)
+        {
+            if (i == accepted.size())
+            {
+                accepted.push_back(acceptedElements(batch, filterIndexes[i].accepts));
+            }
+            filterIndexes[i].values->merge(accepted[i]);
+        }
+
+        elements.merge(batch);
+        primes.merge(batchPrimes);
+
+        ++generation;
+    }
+
+    template <typename T, template <typename> class Storage>
+    vector<T> BasicMagicalContainer<T, Storage>::acceptedElements(const vector<T> &batch, bool (*accepts)(const T &))
+    {
+        vector<T> accepted;
+        for (T element : batch)
+        {
+            if (accepts(element))
+            {
+                accepted.push_back(element);
+            }
+        }
+        return accepted;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::removeElement(T element_to_remove)
+    {
+        auto lock = writeLock();
+        if (!elements.erase(element_to_remove))
+        {
+            throw std::runtime_error("Can't remove a non-existing element");
+        }
+
+        primes.erase(element_to_remove);
+        for (FilterIndex &index : filterIndexes)
+        {
+            index.values->erase(element_to_remove);
+        }
+        ++generation;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::removeElements(std::span<const T> elements_to_remove)
+    {
+        removeBatch(vector<T>(elements_to_remove.begin(), elements_to_remove.end()));
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::removeBatch(vector<T> batch)
+    {
+        if (batch.empty())
+        {
+            return;
+        }
+
+        sort(batch.begin(), batch.end());
+        auto lock = writeLock();
+
+        // Check every element exists before touching the container, a repeated element can't be removed twice
+        if (adjacent_find(batch.begin(), batch.end()) != batch.end())
+        {
+            throw std::runtime_error("Can't remove a non-existing element");
+        }
+
+        for (T element_to_remove : batch)
+        {
+            if (!elements.contains(element_to_remove))
+            {
+                throw std::runtime_error("Can't remove a non-existing element");
+            }
+        }
+
+        // Keep everything that isn't in the batch, in a single pass over the storage
+        elements.eraseAll(batch);
+        primes.eraseAll(batch);
+        for (FilterIndex &index : filterIndexes)
+        {
+            index.values->eraseAll(batch);
+        }
+
+        ++generation;
+    }
+
+    template <typename T, template <typename> class Storage>
+    int BasicMagicalContainer<T, Storage>::size() const
+    {
+        auto lock = readLock();
+        return static_cast<int>(elements.size());
+    }
+
+    template <typename T, template <typename> class Storage>
+    int BasicMagicalContainer<T, Storage>::primeCount() const
+    {
+        auto lock = readLock();
+        return static_cast<int>(primes.size());
+    }
+
+    template <typename T, template <typename> class Storage>
+    const typename BasicMagicalContainer<T, Storage>::ElementStorage &BasicMagicalContainer<T, Storage>::filterIndex(bool (*accepts)(const T &))
+    {
+        // Every iterator of an indexed predicate comes here, so finding the index must not block other readers
+        {
+            auto lock = readLock();
+            if (const ElementStorage *index = findFilterIndex(accepts))
+            {
+                return *index;
+            }
+        }
+
+        // Building an index changes the container, even though no element changes.
+        // Another thread may have built it while this one waited for the lock
+        auto lock = writeLock();
+        if (const ElementStorage *index = findFilterIndex(accepts))
+        {
+            return *index;
+        }
+
+        // First iterator of this predicate, index the elements it accepts from now on
+        filterIndexes.push_back(FilterIndex{accepts, std::make_unique<ElementStorage>()});
+        filterIndexes.back().values->merge(matchingElements(accepts));
+        return *filterIndexes.back().values;
+    }
+
+    template <typename T, template <typename> class Storage>
+    const typename BasicMagicalContainer<T, Storage>::ElementStorage *BasicMagicalContainer<T, Storage>::findFilterIndex(bool (*accepts)(const T &)) const
+    {
+        for (const FilterIndex &index : filterIndexes)
+        {
+            if (index.accepts == accepts)
+            {
+                return index.values.get();
+            }
+        }
+        return nullptr;
+    }
+
+    template <typename T, template <typename> class Storage>
+    vector<T> BasicMagicalContainer<T, Storage>::matchingElements(bool (*accepts)(const T &)) const
+    {
+        // Block by block, a rank lookup per element would cost a tree descent each
+        vector<T> matching;
+        size_t rank = 0;
+        typename ElementStorage::Block block{};
+        while (rank < elements.size())
+        {
+            block = elements.blockFor(rank, block);
+            for (; rank < block.start + block.items.size(); ++rank)
+            {
+                if (accepts(block.items[rank - block.start]))
+                {
+                    matching.push_back(block.items[rank - block.start]);
+                }
+            }
+        }
+        return matching;
+    }
+
+    // ===============Iterator=================
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(Kind kind, BasicMagicalContainer *original_container)
+    : Iterator(kind, original_container, 0) 
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(Kind kind, BasicMagicalContainer *original_container, int index)
+        : Iterator(kind, original_container, index, nullptr, nullptr)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(Kind kind, BasicMagicalContainer *original_container, int index, bool (*accepts)(const T &), const ElementStorage *filtered)
+        : Iterator(kind, original_container, static_cast<size_t>(index), false, accepts, filtered)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(Kind kind, BasicMagicalContainer *original_container, AtEnd, bool (*accepts)(const T &), const ElementStorage *filtered)
+        : Iterator(kind, original_container, 0, true, accepts, filtered)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(Kind kind, BasicMagicalContainer *original_container, size_t position, bool atEnd, bool (*accepts)(const T &), const ElementStorage *filtered)
+        : original_container(original_container), position(position), kind(kind), shard(0), previousLive(nullptr), nextLive(nullptr), generation(0), anchor(0), anchorMode(Anchor::None),
+          onSuccessor(false), accepts(accepts), filtered(filtered)
+    {
+        link();
+        auto lock = readLock();
+        if (original_container != nullptr)
+        {
+            if (atEnd)
+            {
+                this->position = traversed().size();
+            }
+            settle();
+        }
+        capture();
+    }
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::Iterator(const Iterator &other)
+        : original_container(other.original_container), position(other.position), kind(other.kind), shard(0), previousLive(nullptr), nextLive(nullptr),
+          generation(other.generation), anchor(other.anchor), anchorMode(other.anchorMode), onSuccessor(other.onSuccessor), blocks{other.blocks[0], other.blocks[1]},
+          accepts(other.accepts), filtered(other.filtered)
+    {
+        link();
+    }
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::Iterator::~Iterator()
+    {
+        unlink();
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::link()
+    {
+        if (original_container == nullptr)
+        {
+            return;
+        }
+
+        // The shard of the calling thread, the container's only one unless it is shared
+        shard = (original_container->registryShards == 1) ? 0 : static_cast<unsigned char>(ReadMostlyLock::threadSlot() % original_container->registryShards);
+        auto lock = original_container->registryLock(shard);
+
+        Iterator *&head = original_container->registry[shard].head;
+        nextLive = head;
+        if (nextLive != nullptr)
+        {
+            nextLive->previousLive = this;
+        }
+        head = this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::unlink()
+    {
+        if (original_container == nullptr)
+        {
+            return;
+        }
+
+        // Possibly another thread's shard, when the iterator was made on one thread and dropped on another
+        auto lock = original_container->registryLock(shard);
+
+        if (previousLive != nullptr)
+        {
+            previousLive->nextLive = nextLive;
+        }
+        else
+        {
+            original_container->registry[shard].head = nextLive;
+        }
+
+        if (nextLive != nullptr)
+        {
+            nextLive->previousLive = previousLive;
+        }
+
+        previousLive = nullptr;
+        nextLive = nullptr;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::capture() const
+    {
+        if (original_container == nullptr)
+        {
+            return;
+        }
+
+        generation = original_container->generation;
+        onSuccessor = false;
+
+        const ElementStorage &sequence = traversed();
+        if (sequence.empty())
+        {
+            anchorMode = Anchor::None;
+        }
+        else if (position < sequence.size())
+        {
+            anchorMode = Anchor::At;
+            anchor = (kind == Kind::SideCross) ? cachedRead(sequence, crossToSorted(position, sequence.size()), position % 2) : cachedRead(sequence, position, 0);
+        }
+        else
+        {
+            anchorMode = Anchor::After;
+            anchor = sequence.back();
+        }
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::reanchor() const
+    {
+        const ElementStorage &sequence = traversed();
+        bool successor = onSuccessor;
+
+        // The cached blocks may belong to a layout that no longer exists
+        blocks[0] = typename ElementStorage::Block{};
+        blocks[1] = typename ElementStorage::Block{};
+
+        switch (anchorMode)
+        {
+        case Anchor::None:
+            // Everything in the container is new to the iterator
+            position = 0;
+            break;
+
+        case Anchor::At:
+        {
+            size_t index = sequence.lowerBound(anchor);
+            if (kind != Kind::SideCross)
+            {
+                // If the element was removed this is its successor
+                position = index;
+                successor = successor || index == sequence.size() || sequence[index] != anchor;
+            }
+            else if (index < sequence.size() && sequence[index] == anchor)
+            {
+                // The cross order is reshaped by every change, so go through the sorted index of the element
+                position = sortedToCross(index, sequence.size());
+            }
+            else
+            {
+                position = min(position, sequence.size());
+            }
+            break;
+        }
+
+        case Anchor::After:
+            // Elements bigger than the last one passed are still ahead of the iterator
+            if (kind != Kind::SideCross)
+            {
+                position = sequence.upperBound(anchor);
+            }
+            else
+            {
+                position = sequence.size();
+            }
+            break;
+        }
+
+        settle();
+        capture();
+        onSuccessor = successor;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::settle() const
+    {
+        if (kind != Kind::Filter || filtered != nullptr)
+        {
+            return;
+        }
+
+        const ElementStorage &elements = original_container->elements;
+        while (position < elements.size() && !accepts(cachedRead(elements, position, 0)))
+        {
+            ++position;
+        }
+    }
+
+    template <typename T, template <typename> class Storage>
+    size_t BasicMagicalContainer<T, Storage>::Iterator::copyRun(const ElementStorage &sequence, std::span<T> out)
+    {
+        size_t count = min(out.size(), sequence.size() - position);
+        size_t copied = 0;
+        while (copied < count)
+        {
+            typename ElementStorage::Block &block = blocks[0];
+            if (!block.holds(position))
+            {
+                block = sequence.blockFor(position, block);
+            }
+
+            size_t offset = position - block.start;
+            size_t run = min(count - copied, block.items.size() - offset);
+            std::copy_n(block.items.data() + offset, run, out.data() + copied);
+            copied += run;
+            position += run;
+        }
+
+        capture();
+        return copied;
+    }
+
+    template <typename T, template <typename> class Storage>
+    size_t BasicMagicalContainer<T, Storage>::Iterator::offsetPosition(std::ptrdiff_t offset, size_t size) const
+    {
+        sync();
+        if (original_container == nullptr)
+        {
+            throw std::runtime_error("Iterator is not attached to a container");
+        }
+
+        // Unsigned arithmetic, so a huge offset can't overflow before it is checked
+        size_t distance = (offset < 0) ? size_t(0) - static_cast<size_t>(offset) : static_cast<size_t>(offset);
+        if ((offset < 0) ? distance > position : distance > size - min(position, size))
+        {
+            throw std::runtime_error("Iterator moved out of the container");
+        }
+
+        return (offset < 0) ? position - distance : position + distance;
+    }
+
+    template <typename T, template <typename> class Storage>
+    void BasicMagicalContainer<T, Storage>::Iterator::moveBy(std::ptrdiff_t offset, size_t size)
+    {
+        // Standing on the successor of the removed element already counts as the first step forward
+        sync();
+        if (onSuccessor && offset > 0)
+        {
+            --offset;
+        }
+        position = offsetPosition(offset, size);
+        capture();
+    }
+
+    template <typename T, template <typename> class Storage>
+    const T &BasicMagicalContainer<T, Storage>::Iterator::readAt(const ElementStorage &sequence, std::ptrdiff_t offset) const
+    {
+        size_t index = offsetPosition(offset, sequence.size());
+        if (index == sequence.size())
+        {
+            throw std::runtime_error("Iterator is not pointing to a valid element");
+        }
+
+        return cachedRead(sequence, index, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::Iterator &BasicMagicalContainer<T, Storage>::Iterator::operator=(const Iterator &other)
+    {
+        if (this->original_container != nullptr && this->original_container != other.original_container) {
+            throw runtime_error("Can't use = with iterators which points on diffrent containers");
+        }
+
+        if (this != &other)
+        {
+            // An iterator that isn't attached yet, like a default constructed one, takes the container of the other
+            if (original_container == nullptr)
+            {
+                original_container = other.original_container;
+                link();
+            }
+
+            position = other.position;
+            generation = other.generation;
+            anchor = other.anchor;
+            anchorMode = other.anchorMode;
+            onSuccessor = other.onSuccessor;
+            blocks[0] = other.blocks[0];
+            blocks[1] = other.blocks[1];
+            accepts = other.accepts;
+            filtered = other.filtered;
+        }
+        return *this;
+    }
+
+    // ===============AscendingIterator=================
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::AscendingIterator::AscendingIterator() : Iterator(Iterator::Kind::Ascending) {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::AscendingIterator::AscendingIterator(BasicMagicalContainer &container)
+    : Iterator(Iterator::Kind::Ascending, &container) {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::AscendingIterator::AscendingIterator(BasicMagicalContainer &container, int index)
+    : Iterator(Iterator::Kind::Ascending, &container, index) {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::AscendingIterator::AscendingIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end)
+    : Iterator(Iterator::Kind::Ascending, &container, end, nullptr, nullptr)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::AscendingIterator::AscendingIterator(const AscendingIterator &other)
+    : Iterator(other) {}
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::AscendingIterator &BasicMagicalContainer<T, Storage>::AscendingIterator::operator=(const AscendingIterator &other)
+    {
+        if (this->original_container != nullptr && this->original_container != other.original_container) {
+            throw runtime_error("Can't use = with iterators which points on diffrent containers");
+        }
+        
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        // Call the base class assignment operator
+        Iterator::operator=(other);
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    T BasicMagicalContainer<T, Storage>::AscendingIterator::operator*() const
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr || this->position >= this->original_container->elements.size())
+        {
+            throw std::runtime_error("Iterator is not pointing to a valid element");
+        }
+
+        // Once read, the successor of a removed element is the one the next ++ leaves
+        this->onSuccessor = false;
+        return this->cachedRead(this->original_container->elements, this->position, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::AscendingIterator &BasicMagicalContainer<T, Storage>::AscendingIterator::operator++()
+    {
+        auto lock = this->readLock();
+        this->sync();
+        this->position = this->nextPosition();
+        this->capture();
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    auto BasicMagicalContainer<T, Storage>::AscendingIterator::split(size_t parts) const -> vector<IteratorRange<AscendingIterator>>
+    {
+        return this->template splitInto<AscendingIterator>(parts);
+    }
+
+    template <typename T, template <typename> class Storage>
+    size_t BasicMagicalContainer<T, Storage>::AscendingIterator::nextBatch(std::span<T> out)
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr)
+        {
+            return 0;
+        }
+        return this->copyRun(this->original_container->elements, out);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::AscendingIterator BasicMagicalContainer<T, Storage>::AscendingIterator::operator++(int)
+    {
+        AscendingIterator previous(*this);
+        ++*this;
+        return previous;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::AscendingIterator BasicMagicalContainer<T, Storage>::AscendingIterator::begin()
+    {
+        return AscendingIterator(*this->original_container, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::AscendingIterator BasicMagicalContainer<T, Storage>::AscendingIterator::end()
+    {
+        return AscendingIterator(*this->original_container, typename Iterator::AtEnd{});
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::AscendingIterator> BasicMagicalContainer<T, Storage>::AscendingIterator::rbegin()
+    {
+        return std::reverse_iterator<AscendingIterator>(end());
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::AscendingIterator> BasicMagicalContainer<T, Storage>::AscendingIterator::rend()
+    {
+        return std::reverse_iterator<AscendingIterator>(begin());
+    }
+
+    // ===============SideCrossIterator=================
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::SideCrossIterator::SideCrossIterator() : Iterator(Iterator::Kind::SideCross)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::SideCrossIterator::SideCrossIterator(BasicMagicalContainer &container)
+    : Iterator(Iterator::Kind::SideCross, &container)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::SideCrossIterator::SideCrossIterator(BasicMagicalContainer &container, int index)
+    : Iterator(Iterator::Kind::SideCross, &container, index)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::SideCrossIterator::SideCrossIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end)
+    : Iterator(Iterator::Kind::SideCross, &container, end, nullptr, nullptr)
+    {}
+
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::SideCrossIterator::SideCrossIterator(const SideCrossIterator &other)
+    : Iterator(other)
+    {}
+
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator &BasicMagicalContainer<T, Storage>::SideCrossIterator::operator=(const SideCrossIterator &other)
+    {
+        if (this->original_container != nullptr && this->original_container != other.original_container) {
+            throw runtime_error("Can't use = with iterators which points on diffrent containers");
+        }
+        
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        // Call the base class assignment operator
+        Iterator::operator=(other);
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    auto BasicMagicalContainer<T, Storage>::SideCrossIterator::split(size_t parts) const -> vector<IteratorRange<SideCrossIterator>>
+    {
+        return this->template splitInto<SideCrossIterator>(parts);
+    }
+
+    template <typename T, template <typename> class Storage>
+    size_t BasicMagicalContainer<T, Storage>::SideCrossIterator::nextBatch(std::span<T> out)
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr)
+        {
+            return 0;
+        }
+
+        const ElementStorage &elements = this->original_container->elements;
+        size_t size = elements.size();
+        size_t count = min(out.size(), size - this->position);
+
+        // Interleaves the two ends, each through its own cached block, without the mapping call per element
+        for (size_t i = 0; i < count; ++i, ++this->position)
+        {
+            size_t step = this->position / 2;
+            out[i] = (this->position % 2 == 0) ? this->cachedRead(elements, step, 0) : this->cachedRead(elements, size - 1 - step, 1);
+        }
+
+        this->capture();
+        return count;
+    }
+
+    template <typename T, template <typename> class Storage>
+    T BasicMagicalContainer<T, Storage>::SideCrossIterator::operator*() const
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr || this->position >= this->original_container->elements.size())
+        {
+            throw std::runtime_error("Iterator is not pointing to a valid element");
+        }
+
+        // Even positions walk from the smallest element up, odd positions from the biggest element down
+        return this->cachedRead(this->original_container->elements, crossToSorted(this->position, this->original_container->elements.size()), this->position % 2);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator &BasicMagicalContainer<T, Storage>::SideCrossIterator::operator++()
+    {
+        auto lock = this->readLock();
+        this->sync();
+        this->position = this->nextPosition();
+        this->capture();
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator &BasicMagicalContainer<T, Storage>::SideCrossIterator::operator--()
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr || this->position == 0)
+        {
+            throw std::runtime_error("Iterator has reached the beginning");
+        }
+
+        --this->position;
+        this->capture();
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator BasicMagicalContainer<T, Storage>::SideCrossIterator::operator++(int)
+    {
+        SideCrossIterator previous(*this);
+        ++*this;
+        return previous;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator BasicMagicalContainer<T, Storage>::SideCrossIterator::operator--(int)
+    {
+        SideCrossIterator previous(*this);
+        --*this;
+        return previous;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator BasicMagicalContainer<T, Storage>::SideCrossIterator::begin()
+    {
+        return SideCrossIterator(*this->original_container, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::SideCrossIterator BasicMagicalContainer<T, Storage>::SideCrossIterator::end()
+    {
+        return SideCrossIterator(*this->original_container, typename Iterator::AtEnd{});
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::SideCrossIterator> BasicMagicalContainer<T, Storage>::SideCrossIterator::rbegin()
+    {
+        return std::reverse_iterator<SideCrossIterator>(end());
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::SideCrossIterator> BasicMagicalContainer<T, Storage>::SideCrossIterator::rend()
+    {
+        return std::reverse_iterator<SideCrossIterator>(begin());
+    }
+
+    // ===============PrimeIterator=================
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::PrimeIterator::PrimeIterator() : Iterator(Iterator::Kind::Prime) {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::PrimeIterator::PrimeIterator(BasicMagicalContainer &container)
+    : Iterator(Iterator::Kind::Prime, &container)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::PrimeIterator::PrimeIterator(BasicMagicalContainer &container, int index)
+    : Iterator(Iterator::Kind::Prime, &container, index)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::PrimeIterator::PrimeIterator(BasicMagicalContainer &container, typename Iterator::AtEnd end)
+    : Iterator(Iterator::Kind::Prime, &container, end, nullptr, nullptr)
+    {}
+
+    template <typename T, template <typename> class Storage>
+    BasicMagicalContainer<T, Storage>::PrimeIterator::PrimeIterator(const PrimeIterator &other)
+        : Iterator(other) {}
+
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::PrimeIterator &BasicMagicalContainer<T, Storage>::PrimeIterator::operator=(const PrimeIterator &other)
+    {
+        if (this->original_container != nullptr && this->original_container != other.original_container) {
+            throw runtime_error("Can't use = with iterators which points on diffrent containers");
+        }
+        
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        // Call the base class assignment operator
+        Iterator::operator=(other);
+        return *this;
+    }
+
+    template <typename T, template <typename> class Storage>
+    T BasicMagicalContainer<T, Storage>::PrimeIterator::operator*() const
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr || this->position >= this->original_container->primes.size())
+        {
+            throw std::runtime_error("Iterator is not pointing to a valid element");
+        }
+
+        // Once read, the successor of a removed element is the one the next ++ leaves
+        this->onSuccessor = false;
+        return this->cachedRead(this->original_container->primes, this->position, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::PrimeIterator &BasicMagicalContainer<T, Storage>::PrimeIterator::operator++()
+    {
+        auto lock = this->readLock();
+        this->sync();
+        this->position = this->nextPosition();
+        this->capture();
+        return *this;
+    }
+
+    // Ranks among the primes are positions in the prime index, so the primes split as evenly as the elements
+    template <typename T, template <typename> class Storage>
+    auto BasicMagicalContainer<T, Storage>::PrimeIterator::split(size_t parts) const -> vector<IteratorRange<PrimeIterator>>
+    {
+        return this->template splitInto<PrimeIterator>(parts);
+    }
+
+    // The prime index is already compressed, so a batch of primes is a plain copy like an ascending one
+    template <typename T, template <typename> class Storage>
+    size_t BasicMagicalContainer<T, Storage>::PrimeIterator::nextBatch(std::span<T> out)
+    {
+        auto lock = this->readLock();
+        this->sync();
+        if (this->original_container == nullptr)
+        {
+            return 0;
+        }
+        return this->copyRun(this->original_container->primes, out);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::PrimeIterator BasicMagicalContainer<T, Storage>::PrimeIterator::operator++(int)
+    {
+        PrimeIterator previous(*this);
+        ++*this;
+        return previous;
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::PrimeIterator BasicMagicalContainer<T, Storage>::PrimeIterator::begin()
+    {
+        return PrimeIterator(*this->original_container, 0);
+    }
+
+    template <typename T, template <typename> class Storage>
+    typename BasicMagicalContainer<T, Storage>::PrimeIterator BasicMagicalContainer<T, Storage>::PrimeIterator::end()
+    {
+        return PrimeIterator(*this->original_container, typename Iterator::AtEnd{});
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::PrimeIterator> BasicMagicalContainer<T, Storage>::PrimeIterator::rbegin()
+    {
+        return std::reverse_iterator<PrimeIterator>(end());
+    }
+
+    template <typename T, template <typename> class Storage>
+    std::reverse_iterator<typename BasicMagicalContainer<T, Storage>::PrimeIterator> BasicMagicalContainer<T, Storage>::PrimeIterator::rend()
+    {
+        return std::reverse_iterator<PrimeIterator>(begin());
+    }
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef PARALLEL_FOR_EACH_HPP
+#define PARALLEL_FOR_EACH_HPP
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace ariel
+{
+    // Calls function on every element the iterator has left, from threads threads, the calling one included.
+    // The traversal is split into a few chunks for each thread. A thread takes its own chunks from the back
+    // of its queue and, once they run out, steals from the front of the others, so uneven work keeps every
+    // thread busy. function is called concurrently and must not change the container.
+    // Works with every iterator that has split and nextBatch
+    template <typename Walker, typename Function>
+    void parallelForEach(const Walker &iterator, Function function, unsigned threads = std::thread::hardware_concurrency())
+    {
+        using T = typename Walker::value_type;
+        constexpr size_t ChunksPerThread = 4;
+        constexpr size_t BatchSize = 256;
+
+        threads = std::max(threads, 1U);
+
+        // Every iterator is copied here, iterators register with their container and that isn't safe to do concurrently
+        struct Chunk
+        {
+            Walker first;
+            size_t count;
+        };
+        std::vector<Chunk> chunks;
+        for (const auto &range : iterator.split(threads * ChunksPerThread))
+        {
+            chunks.push_back(Chunk{range.begin(), range.size()});
+        }
+
+        // Chunk i starts in the queue of thread i % threads, so neighbouring chunks start on different threads
+        struct Queue
+        {
+            std::mutex lock;
+            std::deque<size_t> chunks;
+        };
+        std::vector<Queue> queues(threads);
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+            queues[i % threads].chunks.push_back(i);
+        }
+
+        auto take = [&](size_t self, size_t &chunk)
+        {
+            {
+                std::lock_guard<std::mutex> guard(queues[self].lock);
+                if (!queues[self].chunks.empty())
+                {
+                    chunk = queues[self].chunks.back();
+                    queues[self].chunks.pop_back();
+                    return true;
+                }
+            }
+
+            for (size_t offset = 1; offset < threads; ++offset)
+            {
+                Queue &victim = queues[(self + offset) % threads];
+                std::lock_guard<std::mutex> guard(victim.lock);
+                if (!victim.chunks.empty())
+                {
+                    chunk = victim.chunks.front();
+                    victim.chunks.pop_front();
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        // The first exception stops the threads from taking more chunks and is rethrown on the calling thread
+        std::exception_ptr failure;
+        std::mutex failureLock;
+        std::atomic<bool> failed(false);
+
+        auto work = [&](size_t self)
+        {
+            std::vector<T> buffer(BatchSize);
+            size_t index = 0;
+            while (!failed.load(std::memory_order_relaxed) && take(self, index))
+            {
+                Chunk &chunk = chunks[index];
+                try
+                {
+                    while (chunk.count > 0)
+                    {
+                        size_t count = chunk.first.nextBatch(std::span<T>(buffer.data(), std::min(BatchSize, chunk.count)));
+                        if (count == 0)
+                        {
+                            break;
+                        }
+
+                        for (size_t i = 0; i < count; ++i)
+                        {
+                            function(buffer[i]);
+                        }
+                        chunk.count -= count;
+                    }
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> guard(failureLock);
+                    if (!failure)
+                    {
+                        failure = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t self = 1; self < threads; ++self)
+        {
+            workers.emplace_back(work, self);
+        }
+        work(0);
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+
+        if (failure)
+        {
+            std::rethrow_exception(failure);
+        }
+    }
+}
+
+#endif
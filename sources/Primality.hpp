@@ -0,0 +1,183 @@
+#ifndef PRIMALITY_HPP
+#define PRIMALITY_HPP
+#include "PrimeSieve.hpp"
+#include "SmallPrimes.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace ariel
+{
+    // The unsigned type the primality test of T works in: at least 32 bits, so 16-bit elements
+    // share the 32-bit path and 64-bit arithmetic is only paid for values that need it
+    template <typename T>
+    using PrimalityWord = std::conditional_t<(sizeof(T) <= sizeof(uint32_t)), uint32_t, uint64_t>;
+
+    // The inverse of an odd number modulo 2^bits of Word. Newton's iteration doubles the correct low bits
+    // every step, and an odd number is its own inverse mod 8
+    template <typename Word>
+    constexpr Word inverseOfOdd(Word odd)
+    {
+        Word inverse = odd;
+        for (int step = 0; step < 5; ++step)
+        {
+            inverse *= 2 - odd * inverse;
+        }
+        return inverse;
+    }
+
+    // Arithmetic modulo an odd number in Montgomery form, multiplications reduce with shifts instead of divisions
+    template <typename Word>
+    class Montgomery
+    {
+        using Wide = std::conditional_t<std::is_same_v<Word, uint32_t>, uint64_t, unsigned __int128>;
+        static constexpr int Bits = std::numeric_limits<Word>::digits;
+
+        Word modulus;
+        Word inverse;  // modulus^-1 mod 2^Bits
+        Word rSquared; // 2^(2*Bits) mod modulus, converts into the form
+
+    public:
+        Word one;      // 1 in Montgomery form
+        Word minusOne; // modulus - 1 in Montgomery form
+
+        constexpr explicit Montgomery(Word modulus) : modulus(modulus), inverse(inverseOfOdd(modulus)), rSquared(0), one(0), minusOne(0)
+        {
+            one = static_cast<Word>(-modulus) % modulus;
+            minusOne = modulus - one;
+            rSquared = static_cast<Word>(static_cast<Wide>(one) * one % modulus);
+        }
+
+        constexpr Word reduce(Wide value) const
+        {
+            // value - m * modulus has no low half, so only the high halves are subtracted
+            Word m = static_cast<Word>(value) * inverse;
+            Word high = static_cast<Word>(value >> Bits);
+            Word correction = static_cast<Word>((static_cast<Wide>(m) * modulus) >> Bits);
+            return (high >= correction) ? high - correction : high - correction + modulus;
+        }
+
+        constexpr Word multiply(Word left, Word right) const
+        {
+            return reduce(static_cast<Wide>(left) * right);
+        }
+
+        constexpr Word toForm(Word value) const
+        {
+            return multiply(value % modulus, rSquared);
+        }
+
+        constexpr Word power(Word base, Word exponent) const
+        {
+            Word result = one;
+            while (exponent != 0)
+            {
+                if ((exponent & 1) != 0)
+                {
+                    result = multiply(result, base);
+                }
+                base = multiply(base, base);
+                exponent >>= 1;
+            }
+            return result;
+        }
+    };
+
+    // Strong probable prime test of an odd number against every base, bases that are multiples of it are skipped
+    template <typename Word, std::size_t Count>
+    constexpr bool millerRabin(Word number, const std::array<Word, Count> &bases)
+    {
+        const Montgomery<Word> field(number);
+        const int twos = std::countr_zero(static_cast<Word>(number - 1));
+        const Word odd = (number - 1) >> twos;
+
+        for (Word base : bases)
+        {
+            if (base % number == 0)
+            {
+                continue;
+            }
+
+            Word witness = field.power(field.toForm(base), odd);
+            if (witness == field.one || witness == field.minusOne)
+            {
+                continue;
+            }
+
+            bool composite = true;
+            for (int square = 1; square < twos && composite; ++square)
+            {
+                witness = field.multiply(witness, witness);
+                composite = (witness != field.minusOne);
+            }
+
+            if (composite)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Deterministic witness sets: {2, 7, 61} holds below 4759123141, the seven bases of Jim Sinclair for every 64-bit number
+    inline constexpr std::array<uint32_t, 3> Witnesses32 = {2, 7, 61};
+    inline constexpr std::array<uint64_t, 7> Witnesses64 = {2, 325, 9375, 28178, 450775, 9780504, 1795265022};
+
+    // What gets past the wheel is divided by these before any modular exponentiation
+    inline constexpr std::array<uint32_t, 14> PreFilterPrimes = {11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61};
+
+    template <typename T>
+    constexpr bool isPrime(T number)
+    {
+        static_assert(std::is_integral_v<T>, "Only integers can be prime");
+
+        if (number <= 1)
+        {
+            return false;
+        }
+
+        using Word = PrimalityWord<T>;
+        Word value = static_cast<Word>(number);
+        if (value < SmallPrimeLimit)
+        {
+            return isSmallPrime(static_cast<uint32_t>(value));
+        }
+
+        if (!WheelCoprime[value % WheelModulus])
+        {
+            return false;
+        }
+
+        // At run time the values the shared sieve covers cost one bit lookup
+        if (!std::is_constant_evaluated() && value < PrimeSieve::Limit)
+        {
+            return PrimeSieve::shared().isPrime(value);
+        }
+
+        // Every value here is above 2^16, so a divisor always means composite
+        for (uint32_t prime : PreFilterPrimes)
+        {
+            if (value % prime == 0)
+            {
+                return false;
+            }
+        }
+
+        // 64-bit elements that fit in 32 bits take the cheaper 32-bit path
+        if constexpr (std::is_same_v<Word, uint64_t>)
+        {
+            if (value > std::numeric_limits<uint32_t>::max())
+            {
+                return millerRabin(value, Witnesses64);
+            }
+        }
+
+        return millerRabin(static_cast<uint32_t>(value), Witnesses32);
+    }
+}
+
+#endif
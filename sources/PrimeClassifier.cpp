@@ -0,0 +1,155 @@
+#include "PrimeClassifier.hpp"
+#include <bit>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MAGICAL_HAS_X86 1
+#endif
+
+namespace ariel
+{
+    // The odd primes the vector pre-filter divides by, those of the wheel and of the scalar pre-filter up to 31.
+    // Every further prime removes less than 3% of what is left, not worth its multiplication
+    static constexpr std::array<uint32_t, 10> FilterPrimes = {3, 5, 7, 11, 13, 17, 19, 23, 29, 31};
+
+    // A word is a multiple of the odd prime exactly when word * prime^-1 wraps to at most UINT32_MAX / prime,
+    // one multiplication per lane instead of a division
+    static constexpr std::array<uint32_t, 10> makeFilterInverses()
+    {
+        std::array<uint32_t, 10> inverses{};
+        for (size_t i = 0; i < FilterPrimes.size(); ++i)
+        {
+            inverses[i] = inverseOfOdd(FilterPrimes[i]);
+        }
+        return inverses;
+    }
+
+    static constexpr std::array<uint32_t, 10> makeFilterLimits()
+    {
+        std::array<uint32_t, 10> limits{};
+        for (size_t i = 0; i < FilterPrimes.size(); ++i)
+        {
+            limits[i] = UINT32_MAX / FilterPrimes[i];
+        }
+        return limits;
+    }
+
+    static constexpr std::array<uint32_t, 10> FilterInverses = makeFilterInverses();
+    static constexpr std::array<uint32_t, 10> FilterLimits = makeFilterLimits();
+
+    // The scalar path, for the values past the last full block and for processors without AVX2
+    template <typename Word>
+    static void classifyScalar(std::span<const Word> values, size_t from, PrimeBits &bits)
+    {
+        for (size_t i = from; i < values.size(); ++i)
+        {
+            if (isPrime(values[i]))
+            {
+                bits[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+
+#ifdef MAGICAL_HAS_X86
+    // Eight values widened to 32-bit lanes
+    template <typename Word>
+    __attribute__((target("avx2"))) static __m256i loadLanes(const Word *values)
+    {
+        if constexpr (sizeof(Word) == 2)
+        {
+            return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values)));
+        }
+        else
+        {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+        }
+    }
+
+    // Classifies whole blocks of eight values and returns how many values it did
+    template <typename Word>
+    __attribute__((target("avx2"))) static size_t classifyBlocksAvx2(std::span<const Word> values, PrimeBits &bits)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i one = _mm256_set1_epi32(1);
+        const __m256i two = _mm256_set1_epi32(2);
+
+        // Broadcast the filter once, not once per block
+        __m256i primes[FilterPrimes.size()];
+        __m256i inverses[FilterPrimes.size()];
+        __m256i limits[FilterPrimes.size()];
+        for (size_t i = 0; i < FilterPrimes.size(); ++i)
+        {
+            primes[i] = _mm256_set1_epi32(static_cast<int>(FilterPrimes[i]));
+            inverses[i] = _mm256_set1_epi32(static_cast<int>(FilterInverses[i]));
+            limits[i] = _mm256_set1_epi32(static_cast<int>(FilterLimits[i]));
+        }
+
+        size_t done = 0;
+        for (; done + 8 <= values.size(); done += 8)
+        {
+            __m256i lanes = loadLanes(values.data() + done);
+
+            // Negative values, 0, 1 and the even values other than 2 are settled before any division
+            __m256i composite = _mm256_cmpeq_epi32(_mm256_min_epu32(lanes, one), lanes);
+            if constexpr (std::is_signed_v<Word>)
+            {
+                composite = _mm256_or_si256(composite, _mm256_cmpgt_epi32(zero, lanes));
+            }
+            __m256i even = _mm256_cmpeq_epi32(_mm256_and_si256(lanes, one), zero);
+            composite = _mm256_or_si256(composite, _mm256_andnot_si256(_mm256_cmpeq_epi32(lanes, two), even));
+
+            for (size_t i = 0; i < FilterPrimes.size(); ++i)
+            {
+                __m256i product = _mm256_mullo_epi32(lanes, inverses[i]);
+                __m256i divisible = _mm256_cmpeq_epi32(_mm256_min_epu32(product, limits[i]), product);
+                composite = _mm256_or_si256(composite, _mm256_andnot_si256(_mm256_cmpeq_epi32(lanes, primes[i]), divisible));
+            }
+
+            // Lanes without a small factor go to the scalar test, a table or sieve lookup for most of them
+            unsigned survivors = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(composite))) & 0xFFU;
+            uint64_t primeLanes = 0;
+            while (survivors != 0)
+            {
+                int lane = std::countr_zero(survivors);
+                survivors &= survivors - 1;
+                if (isPrime(values[done + static_cast<size_t>(lane)]))
+                {
+                    primeLanes |= uint64_t(1) << lane;
+                }
+            }
+            bits[done / 64] |= primeLanes << (done % 64);
+        }
+        return done;
+    }
+#endif
+
+    template <typename Word>
+    static void classifyWords(std::span<const Word> values, PrimeBits &bits)
+    {
+        bits.assign((values.size() + 63) / 64, 0);
+
+        size_t done = 0;
+#ifdef MAGICAL_HAS_X86
+        if (__builtin_cpu_supports("avx2"))
+        {
+            done = classifyBlocksAvx2(values, bits);
+        }
+#endif
+        classifyScalar(values, done, bits);
+    }
+
+    void classifyPrimes(std::span<const int16_t> values, PrimeBits &bits)
+    {
+        classifyWords(values, bits);
+    }
+
+    void classifyPrimes(std::span<const int32_t> values, PrimeBits &bits)
+    {
+        classifyWords(values, bits);
+    }
+
+    void classifyPrimes(std::span<const uint32_t> values, PrimeBits &bits)
+    {
+        classifyWords(values, bits);
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef PRIME_CLASSIFIER_HPP
+#define PRIME_CLASSIFIER_HPP
+#include "Primality.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace ariel
+{
+    // One bit for each classified value, bit i % 64 of word i / 64 is set when value i is prime
+    using PrimeBits = std::vector<uint64_t>;
+
+    inline bool testPrimeBit(const PrimeBits &bits, std::size_t index)
+    {
+        return ((bits[index / 64] >> (index % 64)) & 1) != 0;
+    }
+
+    // Batched isPrime for bulk loads. Blocks of eight values are tested against the small primes with AVX2
+    // when the processor has it, and only the values no small prime divides reach the scalar test
+    void classifyPrimes(std::span<const int16_t> values, PrimeBits &bits);
+    void classifyPrimes(std::span<const int32_t> values, PrimeBits &bits);
+    void classifyPrimes(std::span<const uint32_t> values, PrimeBits &bits);
+
+    // Every other element type is classified one value at a time
+    template <typename T>
+    void classifyPrimes(std::span<const T> values, PrimeBits &bits)
+    {
+        bits.assign((values.size() + 63) / 64, 0);
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            if (isPrime(values[i]))
+            {
+                bits[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "PrimeSieve.hpp"
+#include "SmallPrimes.hpp"
+
+namespace ariel
+{
+    PrimeSieve &PrimeSieve::shared()
+    {
+        static PrimeSieve sieve;
+        return sieve;
+    }
+
+    PrimeSieve::PrimeSieve()
+    {
+        for (std::atomic<const uint64_t *> &bits : published)
+        {
+            bits.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    size_t PrimeSieve::sievedCount() const
+    {
+        size_t count = 0;
+        for (size_t index = 0; index < MaxSegments; ++index)
+        {
+            count += sieved(index) ? 1U : 0U;
+        }
+        return count;
+    }
+
+    const uint64_t *PrimeSieve::sieve(size_t index)
+    {
+        std::lock_guard<std::mutex> lock(growth);
+
+        // Another thread may have sieved the segment while this one waited
+        const uint64_t *bits = published[index].load(std::memory_order_relaxed);
+        if (bits == nullptr)
+        {
+            segments[index] = std::make_unique<uint64_t[]>(SegmentWords);
+            sieveSegment(index, segments[index].get());
+
+            // The bits are written before the release, so a thread that sees the pointer sees them
+            bits = segments[index].get();
+            published[index].store(bits, std::memory_order_release);
+        }
+        return bits;
+    }
+
+    void PrimeSieve::sieveSegment(size_t index, uint64_t *bits) const
+    {
+        // Bit i stands for the odd number low + 2i + 1, every bit starts as prime
+        const uint64_t low = index * SegmentSpan;
+        const uint64_t high = low + SegmentSpan;
+        for (size_t word = 0; word < SegmentWords; ++word)
+        {
+            bits[word] = ~uint64_t(0);
+        }
+
+        if (index == 0)
+        {
+            bits[0] &= ~uint64_t(1); // 1 isn't prime
+        }
+
+        // The compile-time table holds every base prime up to the square root of Limit
+        static_assert(uint64_t(SmallPrimeLimit) * SmallPrimeLimit >= Limit);
+        for (uint32_t prime : SmallPrimes)
+        {
+            if (prime == 2)
+            {
+                continue;
+            }
+
+            uint64_t square = uint64_t(prime) * prime;
+            if (square >= high)
+            {
+                break;
+            }
+
+            // The first odd multiple inside the segment, the multiples below the square were crossed by smaller primes
+            uint64_t multiple = square;
+            if (multiple < low)
+            {
+                multiple = (low + prime - 1) / prime * prime;
+                if (multiple % 2 == 0)
+                {
+                    multiple += prime;
+                }
+            }
+
+            for (; multiple < high; multiple += 2 * uint64_t(prime))
+            {
+                uint64_t bit = (multiple - low) / 2;
+                bits[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+            }
+        }
+    }
+}
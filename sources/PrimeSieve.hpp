@@ -0,0 +1,69 @@
+#ifndef PRIME_SIEVE_HPP
+#define PRIME_SIEVE_HPP
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace ariel
+{
+    // Process-wide Sieve of Eratosthenes over the odd numbers, split in segments that are sieved the first time a value
+    // inside them is asked about. Every segment is sieved on its own from the compile-time base primes, so a big value
+    // doesn't pay for the segments below it. A segment never changes once it is published, so lookups don't lock;
+    // only sieving a segment takes the mutex.
+    class PrimeSieve
+    {
+    public:
+        static constexpr uint64_t SegmentSpan = uint64_t(1) << 20; // Numbers per segment, the odd ones fill 64 KiB of bits
+        static constexpr size_t MaxSegments = 32;
+        static constexpr uint64_t Limit = SegmentSpan * MaxSegments; // Values from here on are left to Miller-Rabin
+
+        static PrimeSieve &shared();
+
+        // value must be below Limit
+        bool isPrime(uint64_t value)
+        {
+            if (value % 2 == 0)
+            {
+                return value == 2;
+            }
+
+            size_t segment = static_cast<size_t>(value / SegmentSpan);
+            const uint64_t *bits = published[segment].load(std::memory_order_acquire);
+            if (bits == nullptr)
+            {
+                bits = sieve(segment);
+            }
+
+            uint64_t bit = (value % SegmentSpan) / 2;
+            return ((bits[bit / 64] >> (bit % 64)) & 1) != 0;
+        }
+
+        // Whether the values of a segment are answered without sieving anything new
+        bool sieved(size_t segment) const
+        {
+            return published[segment].load(std::memory_order_acquire) != nullptr;
+        }
+
+        size_t sievedCount() const;
+
+        PrimeSieve(const PrimeSieve &) = delete;
+        PrimeSieve &operator=(const PrimeSieve &) = delete;
+
+    private:
+        static constexpr size_t SegmentWords = SegmentSpan / 2 / 64;
+
+        std::array<std::unique_ptr<uint64_t[]>, MaxSegments> segments;
+        std::array<std::atomic<const uint64_t *>, MaxSegments> published; // The complete segments, nullptr until sieved
+        std::mutex growth;
+
+        PrimeSieve();
+
+        const uint64_t *sieve(size_t index);
+        void sieveSegment(size_t index, uint64_t *bits) const;
+    };
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "ReadMostlyLock.hpp"
+#include <thread>
+
+namespace ariel
+{
+    size_t ReadMostlyLock::threadSlot()
+    {
+        // Up to Slots threads never share a slot, more than that share them in turn
+        static std::atomic<size_t> nextSlot(0);
+        thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % Slots;
+        return slot;
+    }
+
+    ReadMostlyLock::ReadMostlyLock() : writing(false)
+    {
+        for (Slot &slot : slots)
+        {
+            slot.readers.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void ReadMostlyLock::lock()
+    {
+        writers.lock();
+        writing.store(true, std::memory_order_seq_cst);
+
+        // New readers step back once they see the flag, the ones already in finish first
+        while (readersLeft())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    bool ReadMostlyLock::try_lock()
+    {
+        if (!writers.try_lock())
+        {
+            return false;
+        }
+
+        writing.store(true, std::memory_order_seq_cst);
+        if (readersLeft())
+        {
+            unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void ReadMostlyLock::unlock()
+    {
+        writing.store(false, std::memory_order_release);
+        writers.unlock();
+    }
+
+    bool ReadMostlyLock::readersLeft() const
+    {
+        // Sequentially consistent like the store of the flag before it, acquire alone would let the
+        // writer read a slot from before a reader counted itself while that reader misses the flag
+        for (const Slot &slot : slots)
+        {
+            if (slot.readers.load(std::memory_order_seq_cst) != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void ReadMostlyLock::waitForWriter() const
+    {
+        while (writing.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef READ_MOSTLY_LOCK_HPP
+#define READ_MOSTLY_LOCK_HPP
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace ariel
+{
+    // Reader-writer lock for data that is read far more often than it is written.
+    // Every thread counts its readers in a slot of its own cache line, so readers never write a line another
+    // reader writes; a writer raises a flag and waits for every slot to drain.
+    // A reader must not lock it twice, and unlocks it on the thread that locked it.
+    // Meets the SharedMutex requirements, so std::shared_lock and std::unique_lock work with it.
+    class ReadMostlyLock
+    {
+    public:
+        static constexpr size_t Slots = 64;
+
+        // The slot of the calling thread, threads take the slots in turn
+        static size_t threadSlot();
+
+        ReadMostlyLock();
+
+        void lock_shared()
+        {
+            while (!try_lock_shared())
+            {
+                // A writer is waiting or writing, stay out of its way until it is done
+                waitForWriter();
+            }
+        }
+
+        bool try_lock_shared()
+        {
+            // Counting first and checking the flag after, in the opposite order of lock(), means
+            // either the reader sees the writer or the writer sees the reader
+            std::atomic<unsigned> &readers = slots[threadSlot()].readers;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!writing.load(std::memory_order_seq_cst))
+            {
+                return true;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+
+        void unlock_shared()
+        {
+            slots[threadSlot()].readers.fetch_sub(1, std::memory_order_release);
+        }
+
+        void lock();
+        bool try_lock();
+        void unlock();
+
+        ReadMostlyLock(const ReadMostlyLock &) = delete;
+        ReadMostlyLock &operator=(const ReadMostlyLock &) = delete;
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<unsigned> readers;
+        };
+
+        std::array<Slot, Slots> slots;
+        std::atomic<bool> writing;
+        std::mutex writers; // Writers run one at a time
+
+        void waitForWriter() const;
+        bool readersLeft() const;
+    };
+}
+
+#endif
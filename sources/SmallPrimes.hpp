@@ -0,0 +1,84 @@
+#ifndef SMALL_PRIMES_HPP
+#define SMALL_PRIMES_HPP
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ariel
+{
+    // Tables built by the compiler, so small values are settled without any work at run time
+    inline constexpr uint32_t SmallPrimeLimit = uint32_t(1) << 16;
+    inline constexpr std::size_t SmallPrimeCount = 6542; // The primes below 2^16
+
+    // One bit for each odd number below SmallPrimeLimit, bit i stands for 2i + 1
+    constexpr std::array<uint64_t, SmallPrimeLimit / 128> makeSmallPrimeBits()
+    {
+        std::array<uint64_t, SmallPrimeLimit / 128> bits{};
+        for (uint64_t &word : bits)
+        {
+            word = ~uint64_t(0);
+        }
+        bits[0] &= ~uint64_t(1); // 1 isn't prime
+
+        for (uint32_t number = 3; number * number < SmallPrimeLimit; number += 2)
+        {
+            if (((bits[number / 128] >> (number / 2 % 64)) & 1) == 0)
+            {
+                continue;
+            }
+
+            for (uint32_t multiple = number * number; multiple < SmallPrimeLimit; multiple += 2 * number)
+            {
+                bits[multiple / 128] &= ~(uint64_t(1) << (multiple / 2 % 64));
+            }
+        }
+        return bits;
+    }
+
+    inline constexpr std::array<uint64_t, SmallPrimeLimit / 128> SmallPrimeBits = makeSmallPrimeBits();
+
+    // value must be below SmallPrimeLimit
+    constexpr bool isSmallPrime(uint32_t value)
+    {
+        if (value % 2 == 0)
+        {
+            return value == 2;
+        }
+        return ((SmallPrimeBits[value / 128] >> (value / 2 % 64)) & 1) != 0;
+    }
+
+    // The primes below SmallPrimeLimit in ascending order, for trial division and for seeding sieves
+    constexpr std::array<uint16_t, SmallPrimeCount> makeSmallPrimes()
+    {
+        std::array<uint16_t, SmallPrimeCount> primes{};
+        std::size_t count = 0;
+        for (uint32_t number = 2; number < SmallPrimeLimit; ++number)
+        {
+            if (isSmallPrime(number))
+            {
+                primes[count++] = static_cast<uint16_t>(number);
+            }
+        }
+        return primes;
+    }
+
+    inline constexpr std::array<uint16_t, SmallPrimeCount> SmallPrimes = makeSmallPrimes();
+
+    // Wheel of 2 * 3 * 5 * 7: a number whose residue shares a factor with 210 is a multiple of one of them.
+    // Only 48 of the 210 residues are coprime, so one lookup rejects about 77% of the numbers
+    inline constexpr uint32_t WheelModulus = 210;
+
+    constexpr std::array<bool, WheelModulus> makeWheel()
+    {
+        std::array<bool, WheelModulus> coprime{};
+        for (uint32_t residue = 0; residue < WheelModulus; ++residue)
+        {
+            coprime[residue] = residue % 2 != 0 && residue % 3 != 0 && residue % 5 != 0 && residue % 7 != 0;
+        }
+        return coprime;
+    }
+
+    inline constexpr std::array<bool, WheelModulus> WheelCoprime = makeWheel();
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef SORTED_VECTOR_HPP
+#define SORTED_VECTOR_HPP
+#include "StorageBlock.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace ariel
+{
+    // Flat storage: all the elements in one sorted std::vector.
+    // O(1) access by rank and the fastest scans, but an insert in the middle moves half of the elements.
+    template <typename T>
+    class SortedVector
+    {
+        std::vector<T> items;
+
+    public:
+        using Block = StorageBlock<T>;
+
+        size_t size() const { return items.size(); }
+        bool empty() const { return items.empty(); }
+        const T &operator[](size_t rank) const { return items[rank]; }
+        const T &back() const { return items.back(); }
+
+        size_t lowerBound(const T &value) const
+        {
+            return static_cast<size_t>(std::lower_bound(items.begin(), items.end(), value) - items.begin());
+        }
+
+        size_t upperBound(const T &value) const
+        {
+            return static_cast<size_t>(std::upper_bound(items.begin(), items.end(), value) - items.begin());
+        }
+
+        bool contains(const T &value) const
+        {
+            return std::binary_search(items.begin(), items.end(), value);
+        }
+
+        // Returns false, and changes nothing, if the value is already stored
+        bool insert(const T &value)
+        {
+            auto it = std::lower_bound(items.begin(), items.end(), value);
+            if (it != items.end() && *it == value)
+            {
+                return false;
+            }
+
+            items.insert(it, value);
+            return true;
+        }
+
+        // Returns false if the value isn't stored
+        bool erase(const T &value)
+        {
+            auto it = std::lower_bound(items.begin(), items.end(), value);
+            if (it == items.end() || *it != value)
+            {
+                return false;
+            }
+
+            items.erase(it);
+            return true;
+        }
+
+        // Adds sorted values that aren't stored yet, merging from the back so the vector grows in place in one pass
+        void merge(const std::vector<T> &additions)
+        {
+            size_t oldIndex = items.size();
+            size_t newIndex = additions.size();
+            items.resize(items.size() + additions.size());
+            size_t target = items.size();
+
+            while (newIndex > 0)
+            {
+                if (oldIndex > 0 && items[oldIndex - 1] > additions[newIndex - 1])
+                {
+                    items[--target] = items[--oldIndex];
+                }
+                else
+                {
+                    items[--target] = additions[--newIndex];
+                }
+            }
+        }
+
+        // Removes sorted values in one compaction pass, values that aren't stored are ignored
+        void eraseAll(const std::vector<T> &removals)
+        {
+            auto removed = removals.begin();
+            size_t kept = 0;
+            for (const T &item : items)
+            {
+                while (removed != removals.end() && *removed < item)
+                {
+                    ++removed;
+                }
+
+                if (removed == removals.end() || *removed != item)
+                {
+                    items[kept++] = item;
+                }
+            }
+            items.resize(kept);
+        }
+
+        // The whole vector is a single block
+        Block blockFor(size_t /*rank*/, const Block & /*hint*/) const
+        {
+            return Block{&items, 0, std::span<const T>(items)};
+        }
+    };
+}
+
+#endif
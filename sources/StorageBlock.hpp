@@ -0,0 +1,21 @@
+#ifndef STORAGE_BLOCK_HPP
+#define STORAGE_BLOCK_HPP
+#include <cstddef>
+#include <span>
+
+namespace ariel
+{
+    // A run of consecutive elements of a sorted storage, the first of them at rank start.
+    // Iterators keep the block they read from last, so a sequential scan doesn't search the storage again.
+    template <typename T>
+    struct StorageBlock
+    {
+        const void *node = nullptr; // Storage specific handle, nullptr when the block is empty
+        size_t start = 0;
+        std::span<const T> items;
+
+        bool holds(size_t rank) const { return rank - start < items.size(); }
+    };
+}
+
+#endif